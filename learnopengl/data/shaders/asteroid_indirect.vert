@@ -0,0 +1,24 @@
+#version 460 core
+layout (location = 0) in vec3 a_Position;
+layout (location = 2) in vec2 a_TexCoord;
+
+out vec2 v_TexCoord;
+flat out int v_DrawID;
+
+// Matrices of all asteroids, instances of one level of detail index them from gl_BaseInstance on
+layout (std430, binding = 1) readonly buffer u_InstanceMatrices {
+	mat4 instanceMatrices[];
+};
+layout (std430, binding = 2) readonly buffer u_InstanceIndices {
+	uint instanceIndices[];
+};
+
+uniform mat4 u_Projection;
+uniform mat4 u_View;
+
+void main() {
+	mat4 model = instanceMatrices[instanceIndices[gl_BaseInstance + gl_InstanceID]];
+	gl_Position = u_Projection * u_View * model * vec4(a_Position, 1.0);
+	v_TexCoord = a_TexCoord;
+	v_DrawID = gl_DrawID;
+}
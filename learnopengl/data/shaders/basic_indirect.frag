@@ -0,0 +1,44 @@
+#version 460 core
+#extension GL_EXT_nonuniform_qualifier : enable
+#define MAX_INDIRECT_TEXTURES 16
+
+struct Material {
+    int diffuse;
+    int specular;
+};
+
+in vec2 v_TexCoord;
+flat in int v_DrawID;
+
+out vec4 fragColor;
+
+// One material per draw of the multi-draw, indices point into u_Textures
+layout (std430, binding = 0) readonly buffer u_Materials {
+    Material materials[];
+};
+
+uniform sampler2D u_Textures[MAX_INDIRECT_TEXTURES];
+
+// The material index comes from gl_DrawID and is not dynamically uniform, so it cannot index the sampler array
+// directly. Without the nonuniform qualifier every unit is sampled through a constant index instead.
+vec4 sampleTexture(int index, vec2 uv)
+{
+#ifdef GL_EXT_nonuniform_qualifier
+    return texture(u_Textures[nonuniformEXT(index)], uv);
+#else
+#define SAMPLE_CASE(i) case i: return texture(u_Textures[i], uv);
+    switch (index) {
+        SAMPLE_CASE(0) SAMPLE_CASE(1) SAMPLE_CASE(2) SAMPLE_CASE(3)
+        SAMPLE_CASE(4) SAMPLE_CASE(5) SAMPLE_CASE(6) SAMPLE_CASE(7)
+        SAMPLE_CASE(8) SAMPLE_CASE(9) SAMPLE_CASE(10) SAMPLE_CASE(11)
+        SAMPLE_CASE(12) SAMPLE_CASE(13) SAMPLE_CASE(14) SAMPLE_CASE(15)
+    }
+    return vec4(1.0);
+#endif
+}
+
+void main()
+{
+    int diffuse = materials[v_DrawID].diffuse;
+    fragColor = diffuse >= 0 ? sampleTexture(diffuse, v_TexCoord) : vec4(1.0);
+}
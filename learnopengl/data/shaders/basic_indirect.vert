@@ -0,0 +1,18 @@
+#version 460 core
+layout (location = 0) in vec3 a_Position;
+layout (location = 1) in vec2 a_Normal;
+layout (location = 2) in vec2 a_TexCoord;
+
+out vec2 v_TexCoord;
+flat out int v_DrawID;
+
+uniform mat4 u_Model;
+uniform mat4 u_View;
+uniform mat4 u_Projection;
+
+void main()
+{
+    gl_Position = u_Projection * u_View * u_Model * vec4(a_Position, 1.0);
+    v_TexCoord = a_TexCoord;
+    v_DrawID = gl_DrawID;
+}
@@ -1,6 +1,6 @@
 #version 330 core
 layout (location = 0) in vec3 a_Position;
-layout (location = 1) in vec3 a_Normal;
+layout (location = 1) in vec2 a_Normal;
 
 out vec3 v_Position;
 out vec3 v_Normal;
@@ -10,8 +10,16 @@ uniform mat4 u_View;
 uniform mat4 u_Projection;
 uniform mat4 u_InvTModel;
 
+// Normals arrive octahedral encoded, see EncodeOctahedral()
+vec3 octDecode(vec2 e) {
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+	return normalize(n);
+}
+
 void main() {
-	v_Normal = mat3(u_InvTModel) * a_Normal;
+	v_Normal = mat3(u_InvTModel) * octDecode(a_Normal);
 	v_Position = vec3(u_Model * vec4(a_Position, 1.0));
 	gl_Position = u_Projection * u_View * vec4(v_Position, 1.0);
 }
\ No newline at end of file
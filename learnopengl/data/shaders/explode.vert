@@ -1,6 +1,6 @@
 #version 330 core
 layout (location = 0) in vec3 a_Position;
-layout (location = 1) in vec3 a_Normal;
+layout (location = 1) in vec2 a_Normal;
 layout (location = 2) in vec2 a_TexCoord;
 
 out VS_OUT {
@@ -15,10 +15,10 @@ uniform vec3 u_LightPos;
 uniform vec3 u_ViewPos;
 
 void main() {
-	// Obtain normal from normal map in range [0,1]
-    vec3 normal = texture(u_NormalMap, fs_in.TexCoord).rgb;
-    // Transform normal vector to range [-1,1] in tangent space
-    normal = normalize(normal * 2.0 - 1.0);
+	// Obtain X and Y of the normal in range [0,1], only two channels are kept when the map is BC5 compressed
+    vec2 normalXY = texture(u_NormalMap, fs_in.TexCoord).rg * 2.0 - 1.0;
+    // Rebuild Z from the unit length, tangent space normals always point out of the surface
+    vec3 normal = vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
 
     // If back face is showing, reverse the normals so that lighting works
     if (!gl_FrontFacing) {
@@ -1,6 +1,6 @@
 #version 330 core
 layout (location = 0) in vec3 a_Position;
-layout (location = 1) in vec3 a_Normal;
+layout (location = 1) in vec2 a_Normal;
 
 out VS_OUT {
 	vec3 Normal;
@@ -10,7 +10,15 @@ uniform mat4 u_View;
 uniform mat4 u_Model;
 uniform mat4 u_InvTViewModel;
 
+// Normals arrive octahedral encoded, see EncodeOctahedral()
+vec3 octDecode(vec2 e) {
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+	return normalize(n);
+}
+
 void main() {
 	gl_Position = u_View * u_Model * vec4(a_Position, 1.0);
-	vs_out.Normal = normalize(vec3(u_InvTViewModel * vec4(a_Normal, 1.0)));
+	vs_out.Normal = normalize(vec3(u_InvTViewModel * vec4(octDecode(a_Normal), 1.0)));
 }
@@ -1,4 +1,4 @@
-#version 330 core
+#version 430 core
 struct Material {
     sampler2D diffuse;
     sampler2D specular;
@@ -17,6 +17,7 @@ struct Attenuation {
     float quadratic;
 };
 
+// Field order matches the std140 packing of LightBlock on the CPU
 struct PointLight {
     BasicLight inner;
     vec3 position;
@@ -29,10 +30,10 @@ struct DirectionalLight {
 };
 
 struct SpotLight {
-	BasicLight inner;
+    BasicLight inner;
     vec3 position;
-    vec3 direction;
     float dropOff;
+    vec3 direction;
     float cutOff;
     Attenuation atten;
 };
@@ -47,18 +48,33 @@ in VS_OUT {
 #define MAX_POINT_LIGHTS 4
 #define MAX_SPOT_LIGHTS 4
 
+// Variant defines (ENABLE_BLINN, ENABLE_DIR_LIGHT, NUM_PT_LIGHTS, NUM_SP_LIGHTS), see ShaderVariants
+#ifndef NUM_PT_LIGHTS
+#define NUM_PT_LIGHTS 0
+#endif
+#ifndef NUM_SP_LIGHTS
+#define NUM_SP_LIGHTS 0
+#endif
+#if NUM_PT_LIGHTS > MAX_POINT_LIGHTS
+#error NUM_PT_LIGHTS exceeds MAX_POINT_LIGHTS
+#endif
+#if NUM_SP_LIGHTS > MAX_SPOT_LIGHTS
+#error NUM_SP_LIGHTS exceeds MAX_SPOT_LIGHTS
+#endif
+
 // Camera position
 uniform vec3 u_ViewPos;
 // Fragment material
 uniform Material u_Material;
-// Lights
-uniform int u_NumPtLights = 0;
-uniform int u_NumSpLights = 0;
-uniform int u_EnableDirLight = 0;
-uniform int u_EnableBlinn = 0;
-uniform DirectionalLight u_DirLight;
-uniform PointLight u_PtLights[MAX_POINT_LIGHTS];
-uniform SpotLight u_SpLights[MAX_SPOT_LIGHTS];
+// Lights, the counts and enable flag in the block are replaced by the variant defines
+layout (std140, binding = 1) uniform u_Lights {
+    DirectionalLight u_DirLight;
+    PointLight u_PtLights[MAX_POINT_LIGHTS];
+    SpotLight u_SpLights[MAX_SPOT_LIGHTS];
+    int u_NumPtLights;
+    int u_NumSpLights;
+    int u_EnableDirLight;
+};
 
 // Fragment shader output
 out vec4 fragColor;
@@ -73,14 +89,13 @@ vec3 CalcBasicLight(BasicLight innerLight, vec3 dirToLight, vec3 norm, vec3 view
 
     // Specular
     // Flip the direction to light and reflect against vertex normal to get the direction of light reflection
-    float spec = 0.0;
-    if (u_EnableBlinn > 0) {
-        vec3 halfwayDir = normalize(dirToLight + viewDir);
-        spec = pow(max(dot(norm, halfwayDir), 0.0), u_Material.shininess * 2);
-    } else {
-		vec3 reflectDir = reflect(-dirToLight, normalize(fs_in.normal));
-		spec = pow(max(dot(viewDir, reflectDir), 0.0), u_Material.shininess);
-    }
+#ifdef ENABLE_BLINN
+    vec3 halfwayDir = normalize(dirToLight + viewDir);
+    float spec = pow(max(dot(norm, halfwayDir), 0.0), u_Material.shininess * 2);
+#else
+    vec3 reflectDir = reflect(-dirToLight, normalize(fs_in.normal));
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), u_Material.shininess);
+#endif
     vec3 specularLight = innerLight.specular * spec * vec3(texture(u_Material.specular, fs_in.texCoord));
 
     return ambientLight + diffuseLight + specularLight;
@@ -130,13 +145,13 @@ void main() {
 
     // Calculate contribution from all light sources
     vec3 light = vec3(0.0);
-    if (u_EnableDirLight > 0) {
-		light += CalcDirectionalLightContribution(u_DirLight, norm, viewDir);
-    }
-    for (int i = 0; i < u_NumPtLights; i++) {
-		light += CalcPointLightContribution(u_PtLights[i], norm, viewDir);
+#ifdef ENABLE_DIR_LIGHT
+    light += CalcDirectionalLightContribution(u_DirLight, norm, viewDir);
+#endif
+    for (int i = 0; i < NUM_PT_LIGHTS; i++) {
+        light += CalcPointLightContribution(u_PtLights[i], norm, viewDir);
     }
-    for (int i = 0; i < u_NumSpLights; i++) {
+    for (int i = 0; i < NUM_SP_LIGHTS; i++) {
         light += CalcSpotLightContribution(u_SpLights[i], norm, viewDir);
     }
 
@@ -5,6 +5,20 @@ out vec4 fragColor;
 
 uniform sampler2D u_ScreenTexture;
 
+// Variant define SCREEN_EFFECT selects the post-processing effect, see ShaderVariants
+#define EFFECT_NONE 0
+#define EFFECT_INVERSE 1
+#define EFFECT_GREYSCALE 2
+#define EFFECT_SHARPEN 3
+#define EFFECT_BLUR 4
+#define EFFECT_EDGE_DETECT 5
+#define EFFECT_EMBOSS 6
+
+#ifndef SCREEN_EFFECT
+#define SCREEN_EFFECT EFFECT_NONE
+#endif
+
+#if SCREEN_EFFECT >= EFFECT_SHARPEN
 const float offset = 1.0 / 300.0;
 
 vec4 kernelEffect() {
@@ -20,52 +34,52 @@ vec4 kernelEffect() {
         vec2( offset, -offset)  // bottom-right    
     );
 
-    float sharpenKernel[9] = float[](
+#if SCREEN_EFFECT == EFFECT_SHARPEN
+    float kernel[9] = float[](
          0, -1,  0,
         -1,  5, -1,
          0, -1,  0
     );
-
-    float blurKernel[9] = float[](
+#elif SCREEN_EFFECT == EFFECT_BLUR
+    float kernel[9] = float[](
         1.0 / 16, 2.0 / 16, 1.0 / 16,
 		2.0 / 16, 4.0 / 16, 2.0 / 16,
 		1.0 / 16, 2.0 / 16, 1.0 / 16 
     );
-
-    float edgeDetectKernel[9] = float[](
+#elif SCREEN_EFFECT == EFFECT_EDGE_DETECT
+    float kernel[9] = float[](
         1,  1,  1,
         1, -8,  1,
         1,  1,  1
     );
-
-    float embossKernel[9] = float[](
+#else
+    float kernel[9] = float[](
         -2, -1,  0,
         -1,  1,  1,
          0,  1,  2 
     );
+#endif
 
-    vec3 sampleTex[9];
-    for (int i = 0; i < 9; i++) {
-        sampleTex[i] = vec3(texture(u_ScreenTexture, v_TexCoord.st + offsets[i]));
-    }
     vec3 col = vec3(0.0);
     for (int i = 0; i < 9; i++) {
-        col += sampleTex[i] * sharpenKernel[i];
+        col += vec3(texture(u_ScreenTexture, v_TexCoord.st + offsets[i])) * kernel[i];
     }
 
     return vec4(col, 1.0);
 }
+#endif
 
 void main() {
-    // Apply any post-processing effects here
+    // Apply the post-processing effect of this variant
+#if SCREEN_EFFECT == EFFECT_NONE
+	fragColor = texture(u_ScreenTexture, v_TexCoord);
+#elif SCREEN_EFFECT == EFFECT_INVERSE
+	fragColor = vec4(vec3(1.0 - texture(u_ScreenTexture, v_TexCoord)), 1.0);
+#elif SCREEN_EFFECT == EFFECT_GREYSCALE
 	vec4 texColor = texture(u_ScreenTexture, v_TexCoord);
-	// Inverse
-	vec4 inverseColor = vec4(vec3(1.0 - texColor), 1.0);
-	// Greyscale
-	float avg = (texColor.r + texColor.g + texColor.b) / 3.0;
 	float weightedAvg = 0.2126 * texColor.r + 0.7152 * texColor.g + 0.0722 * texColor.b;
-	vec4 greyScale = vec4(weightedAvg, weightedAvg, weightedAvg, 1.0);
-
-	// Final result
-	fragColor = texColor;
+	fragColor = vec4(weightedAvg, weightedAvg, weightedAvg, 1.0);
+#else
+	fragColor = kernelEffect();
+#endif
 }
\ No newline at end of file
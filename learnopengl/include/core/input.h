@@ -24,6 +24,7 @@ enum class Key : int {
     D = GLFW_KEY_D,
 
     B = GLFW_KEY_B,
+    E = GLFW_KEY_E,
 
     LCtrl = GLFW_KEY_LEFT_CONTROL,
     RCtrl = GLFW_KEY_RIGHT_CONTROL,
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/* MappedFile maps a whole file read-only into memory, the data stays valid for the lifetime of the object */
+class MappedFile {
+   private:
+    const unsigned char* m_Data = nullptr;
+    size_t m_Size = 0;
+#ifdef _WIN32
+    void* m_FileHandle = nullptr;
+    void* m_MappingHandle = nullptr;
+#endif
+
+   public:
+    MappedFile(const std::string& filePath);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Unmap the file early, e.g. to write to it, the data is invalid afterwards
+    void Close();
+
+    inline bool IsValid() const {
+        return m_Data != nullptr;
+    }
+
+    inline const unsigned char* GetData() const {
+        return m_Data;
+    }
+
+    inline size_t GetSize() const {
+        return m_Size;
+    }
+};
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <functional>
+
+namespace Parallel {
+
+// Worker threads used by For(), besides the calling thread
+unsigned int GetWorkerCount();
+
+// Run task(i) for every i in [0, count) on the calling thread and the workers, returns once all tasks are done.
+// Tasks are handed out one at a time so that tasks of uneven size balance out.
+void For(unsigned int count, const std::function<void(unsigned int)>& task);
+
+}  // namespace Parallel
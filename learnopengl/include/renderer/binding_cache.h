@@ -0,0 +1,74 @@
+#pragma once
+
+#include <common.h>
+
+#include <unordered_map>
+
+const unsigned int MAX_CACHED_TEXTURE_UNITS = 32;
+// Marks a binding whose real GL value is not known, so the next bind always reaches the driver
+const unsigned int UNKNOWN_BINDING = 0xFFFFFFFF;
+
+struct BindingStats {
+    unsigned int Hits = 0;
+    unsigned int Misses = 0;
+};
+
+class BindingCacheInst {
+   public:
+    unsigned int m_Program = 0;
+    unsigned int m_VertexArray = 0;
+    unsigned int m_DrawFrameBuffer = 0;
+    unsigned int m_ReadFrameBuffer = 0;
+    unsigned int m_RenderBuffer = 0;
+    unsigned int m_ActiveTextureUnit = 0;
+    unsigned int m_Texture2D[MAX_CACHED_TEXTURE_UNITS] = {};
+    unsigned int m_TextureCubeMap[MAX_CACHED_TEXTURE_UNITS] = {};
+    // Buffer bindings by target, except for element array buffers which are part of the VAO state
+    std::unordered_map<unsigned int, unsigned int> m_Buffers;
+    std::unordered_map<unsigned int, unsigned int> m_ElementBuffers;
+    // Value for buffer bindings seen for the first time
+    unsigned int m_DefaultBuffer = 0;
+    BindingStats m_Stats;
+};
+
+/* BindingCache shadows the GL binding state of the (single) context so that binding an object that is already bound
+ * does not reach the driver. All wrapper Bind() / Unbind() calls go through here. */
+class BindingCache {
+   private:
+    static BindingCacheInst s_Instance;
+
+   public:
+    static void BindProgram(unsigned int id);
+    static void BindVertexArray(unsigned int id);
+    static void BindBuffer(unsigned int target, unsigned int id);
+    static void BindTexture(unsigned int target, unsigned int id);
+    static void BindTextureUnit(unsigned int slot, unsigned int target, unsigned int id);
+    static void BindFrameBuffer(unsigned int target, unsigned int id);
+    static void BindRenderBuffer(unsigned int id);
+    // Record a buffer binding that GL made as a side effect of another call (e.g. glBindBufferRange)
+    static void TrackBuffer(unsigned int target, unsigned int id);
+
+    // Deleted names can be reused by the driver, so they must be dropped from the cache
+    static void DeleteProgram(unsigned int id);
+    static void DeleteVertexArray(unsigned int id);
+    static void DeleteBuffer(unsigned int id);
+    static void DeleteTexture(unsigned int id);
+    static void DeleteFrameBuffer(unsigned int id);
+    static void DeleteRenderBuffer(unsigned int id);
+
+    // Forget all cached state, e.g. after GL calls that bypassed the cache
+    static void Invalidate();
+
+    inline static const BindingStats& GetStats() {
+        return s_Instance.m_Stats;
+    }
+
+    inline static void ResetStats() {
+        s_Instance.m_Stats = BindingStats();
+    }
+
+   private:
+    static bool update(unsigned int& cached, unsigned int id);
+    static unsigned int& cachedBuffer(std::unordered_map<unsigned int, unsigned int>& buffers, unsigned int key);
+    static void activateTextureUnit(unsigned int slot);
+};
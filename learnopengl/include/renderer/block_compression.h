@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Block-compressed formats, every block covers 4x4 texels
+enum class BlockFormat {
+    None,
+    // RGB endpoints with 2-bit indices, 8 bytes per block
+    BC1,
+    // BC1 colour plus an interpolated alpha block, 16 bytes per block
+    BC3,
+    // Two interpolated single channel blocks for red and green, 16 bytes per block
+    BC5,
+};
+
+unsigned int GetBlockBytes(const BlockFormat format);
+
+// Encode / decode a single block of 4x4 RGBA8 texels in row order
+void EncodeBlock(const BlockFormat format, const unsigned char* texels, unsigned char* block);
+void DecodeBlock(const BlockFormat format, const unsigned char* block, unsigned char* texels);
+
+// Whole images are RGBA8, edge blocks of images that are not a multiple of 4 repeat the last row and column
+std::vector<unsigned char> CompressImage(const BlockFormat format, const unsigned char* rgba, const int width,
+                                         const int height);
+std::vector<unsigned char> DecompressImage(const BlockFormat format, const unsigned char* blocks, const int width,
+                                           const int height);
+
+// Peak signal-to-noise ratio in dB over the first `channels` channels of two RGBA8 images, infinite if they are equal
+double ComputePSNR(const unsigned char* a, const unsigned char* b, const size_t texelCount,
+                   const unsigned int channels);
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <renderer/ibo.h>
+#include <renderer/vao.h>
+#include <renderer/vbo.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+const unsigned int DEFAULT_ARENA_PAGE_VERTICES = 1 << 18;
+const unsigned int DEFAULT_ARENA_PAGE_INDICES = 1 << 20;
+
+/* RangeAllocator is a first-fit free-list allocator over [0, capacity) which coalesces neighbouring free ranges */
+class RangeAllocator {
+   private:
+    // Free ranges as offset -> size
+    std::map<unsigned int, unsigned int> m_FreeRanges;
+    unsigned int m_Capacity;
+    unsigned int m_Used;
+
+   public:
+    RangeAllocator(unsigned int capacity);
+
+    bool Allocate(unsigned int size, unsigned int& offset);
+    void Free(unsigned int offset, unsigned int size);
+
+    inline unsigned int GetCapacity() const {
+        return m_Capacity;
+    }
+
+    inline unsigned int GetUsed() const {
+        return m_Used;
+    }
+};
+
+/* GeometryPage is one set of large immutable buffers, all geometry inside a page shares its VAO and index type */
+struct GeometryPage {
+    std::shared_ptr<VertexArray> VAO;
+    std::shared_ptr<VertexBuffer> VBO;
+    std::shared_ptr<IndexBuffer> IBO;
+    RangeAllocator Vertices;
+    RangeAllocator Indices;
+};
+
+/* GeometryRange is a sub-allocation of a page. Indices are relative to BaseVertex. */
+struct GeometryRange {
+    GeometryPage* Page = nullptr;
+    int BaseVertex = 0;
+    unsigned int VertexCount = 0;
+    unsigned int FirstIndex = 0;
+    unsigned int IndexCount = 0;
+};
+
+/* GeometryArena sub-allocates vertex and index ranges for a single vertex format from a few pages. Geometry whose
+ * indices fit 16 bits goes to 16-bit index pages, the rest to 32-bit ones. */
+class GeometryArena {
+   private:
+    VertexBufferLayout m_Layout;
+    unsigned int m_PageVertices, m_PageIndices;
+    std::vector<std::unique_ptr<GeometryPage>> m_Pages;
+
+   public:
+    GeometryArena(const VertexBufferLayout& layout, unsigned int pageVertices = DEFAULT_ARENA_PAGE_VERTICES,
+                  unsigned int pageIndices = DEFAULT_ARENA_PAGE_INDICES);
+
+    GeometryRange Allocate(const void* vertices, unsigned int vertexCount, const unsigned int* indices,
+                           unsigned int indexCount);
+    void Free(const GeometryRange& range);
+
+    std::shared_ptr<VertexArray> CreateVertexArray(const GeometryPage& page) const;
+
+    inline const VertexBufferLayout& GetLayout() const {
+        return m_Layout;
+    }
+
+    inline unsigned int GetPageCount() const {
+        return (unsigned int)m_Pages.size();
+    }
+
+   private:
+    GeometryPage& createPage(unsigned int vertexCount, unsigned int indexCount, unsigned int indexType);
+};
@@ -1,21 +1,44 @@
 #pragma once
 
+#include <common.h>
+
+/* IndexBuffer stores indices in the narrowest type that fits them, callers always pass unsigned int indices and the
+ * draw calls read the type back through GetType() */
 class IndexBuffer {
    private:
     unsigned int m_ReferenceID;
     unsigned int m_Count;
+    unsigned int m_Type;
 
    public:
+    // Narrows the indices to GL_UNSIGNED_SHORT when the largest index allows it
     IndexBuffer(const unsigned int* data, unsigned int count);
+    IndexBuffer(unsigned int count, unsigned int type = GL_UNSIGNED_INT);
     ~IndexBuffer();
 
     void Bind() const;
     void Unbind() const;
 
+    // The indices must fit the type of the buffer
+    void InsertData(unsigned int offset, const unsigned int* data, unsigned int count) const;
+
+    // GL_UNSIGNED_SHORT if every index is below 65536, GL_UNSIGNED_INT otherwise
+    static unsigned int SelectType(const unsigned int* data, unsigned int count);
+    static unsigned int GetSizeOfType(unsigned int type);
+
     inline unsigned int GetCount() const {
         return m_Count;
     }
 
+    inline unsigned int GetType() const {
+        return m_Type;
+    }
+
+    // Size of one index in bytes
+    inline unsigned int GetIndexSize() const {
+        return GetSizeOfType(m_Type);
+    }
+
     inline unsigned int GetReferenceID() const {
         return m_ReferenceID;
     }
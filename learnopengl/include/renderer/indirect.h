@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+
+/* DrawElementsIndirectCommand matches the layout GL expects in a GL_DRAW_INDIRECT_BUFFER */
+struct DrawElementsIndirectCommand {
+    unsigned int Count;
+    unsigned int InstanceCount;
+    unsigned int FirstIndex;
+    int BaseVertex;
+    unsigned int BaseInstance;
+};
+
+class IndirectBuffer {
+   private:
+    unsigned int m_ReferenceID;
+    std::vector<DrawElementsIndirectCommand> m_Commands;
+
+   public:
+    IndirectBuffer(const std::vector<DrawElementsIndirectCommand>& commands);
+    ~IndirectBuffer();
+
+    void Bind() const;
+    void Unbind() const;
+
+    void SetInstanceCount(const unsigned int instances, const unsigned int baseInstance = 0);
+
+    inline unsigned int GetCount() const {
+        return (unsigned int)m_Commands.size();
+    }
+
+    inline const std::vector<DrawElementsIndirectCommand>& GetCommands() const {
+        return m_Commands;
+    }
+
+    inline unsigned int GetReferenceID() const {
+        return m_ReferenceID;
+    }
+};
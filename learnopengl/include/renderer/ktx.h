@@ -0,0 +1,104 @@
+#pragma once
+
+#include <common.h>
+#include <core/mapped_file.h>
+#include <renderer/block_compression.h>
+
+#include <string>
+#include <vector>
+
+// EXT_texture_compression_s3tc and EXT_texture_sRGB are not part of the generated loader
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+// Vulkan format identifiers stored in the KTX2 header
+enum class KtxFormat : unsigned int {
+    RGBA8 = 37,
+    RGBA8_SRGB = 43,
+    BC1_RGB = 131,
+    BC1_RGB_SRGB = 132,
+    BC3 = 137,
+    BC3_SRGB = 138,
+    BC5 = 141,
+};
+
+struct KtxFormatInfo {
+    KtxFormat VkFormat;
+    GLenum InternalFormat;
+    GLenum SrgbInternalFormat;
+    // External format and type, unused for compressed formats
+    GLenum Format;
+    GLenum Type;
+    // Bytes per texel block and block edge in texels (1 for uncompressed formats)
+    unsigned int BlockBytes;
+    unsigned int BlockSize;
+    BlockFormat Block;
+    bool Srgb;
+    // Extension the driver needs to sample the format, nullptr for core formats
+    const char* Extension;
+};
+
+const KtxFormatInfo* FindKtxFormat(unsigned int vkFormat);
+// Size in bytes of one face of a w x h image
+size_t KtxImageSize(const KtxFormatInfo& format, unsigned int width, unsigned int height);
+
+/* KtxLevel points into the mapped file, faces of a level are stored back to back */
+struct KtxLevel {
+    const unsigned char* Data = nullptr;
+    size_t Size = 0;
+};
+
+/* KtxFile reads a KTX2 container through a memory mapping. Only the subset written by WriteKtx is supported: 2D
+ * textures or cube maps, no array layers and no supercompression. */
+class KtxFile {
+   private:
+    MappedFile m_File;
+    const KtxFormatInfo* m_Format;
+    unsigned int m_Width, m_Height, m_FaceCount;
+    std::vector<KtxLevel> m_Levels;
+
+   public:
+    KtxFile(const std::string& filePath);
+
+    inline const KtxFormatInfo& GetFormat() const {
+        return *m_Format;
+    }
+
+    inline unsigned int GetWidth() const {
+        return m_Width;
+    }
+
+    inline unsigned int GetHeight() const {
+        return m_Height;
+    }
+
+    inline unsigned int GetFaceCount() const {
+        return m_FaceCount;
+    }
+
+    inline unsigned int GetLevelCount() const {
+        return (unsigned int)m_Levels.size();
+    }
+
+    inline const KtxLevel& GetLevel(unsigned int level) const {
+        return m_Levels[level];
+    }
+};
+
+/* KtxImage is the in-memory form of a container to be written, with Levels[0] being the full resolution image */
+struct KtxImage {
+    KtxFormat Format = KtxFormat::RGBA8;
+    unsigned int Width = 0, Height = 0;
+    unsigned int FaceCount = 1;
+    std::vector<std::vector<unsigned char>> Levels;
+    // "ru" when rows are stored bottom-up as OpenGL expects, "rd" for top-down
+    std::string Orientation = "ru";
+};
+
+bool WriteKtx(const std::string& filePath, const KtxImage& image);
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <renderer/shader.h>
+#include <renderer/ubo.h>
 
 #include <glm/glm.hpp>
 
@@ -44,11 +44,89 @@ struct SpotLight {
     float DropOff, CutOff;
 };
 
-class Lighting {
+// Must match the u_Lights block in the shaders
+const unsigned int MAX_POINT_LIGHTS = 4;
+const unsigned int MAX_SPOT_LIGHTS = 4;
+const unsigned int LIGHTS_BINDING = 1;
+
+// std140 layouts of the lights, a vec3 takes 16 bytes unless a scalar follows it
+struct PackedBasicLight {
+    glm::vec3 Ambient;
+    float Pad0;
+    glm::vec3 Diffuse;
+    float Pad1;
+    glm::vec3 Specular;
+    float Pad2;
+};
+
+struct PackedAttenuation {
+    float Constant, Linear, Quadratic, Pad;
+};
+
+struct PackedPointLight {
+    PackedBasicLight Inner;
+    glm::vec3 Position;
+    float Pad;
+    PackedAttenuation Atten;
+};
+
+struct PackedDirectionalLight {
+    PackedBasicLight Inner;
+    glm::vec3 Direction;
+    float Pad;
+};
+
+struct PackedSpotLight {
+    PackedBasicLight Inner;
+    glm::vec3 Position;
+    float DropOff;
+    glm::vec3 Direction;
+    float CutOff;
+    PackedAttenuation Atten;
+};
+
+struct LightBlock {
+    PackedDirectionalLight DirLight;
+    PackedPointLight PtLights[MAX_POINT_LIGHTS];
+    PackedSpotLight SpLights[MAX_SPOT_LIGHTS];
+    int NumPtLights;
+    int NumSpLights;
+    int EnableDirLight;
+    int Pad;
+};
+
+static_assert(sizeof(PackedPointLight) == 80 && sizeof(PackedDirectionalLight) == 64 && sizeof(PackedSpotLight) == 96);
+static_assert(sizeof(LightBlock) == 784);
+
+/* LightBuffer keeps a CPU copy of the u_Lights uniform block. Setters only mark the bytes that actually changed and
+ * Upload writes them to the buffer with a single call. */
+class LightBuffer {
+   private:
+    UniformBuffer m_UBO;
+    LightBlock m_Block;
+    // Byte range of m_Block that differs from the buffer contents
+    unsigned int m_DirtyBegin, m_DirtyEnd;
+
    public:
-    static void SetDirectionalLight(Shader& shader, const std::string& name, const DirectionalLight& directLight);
-    static void SetPointLights(Shader& shader, const std::string& numName, const unsigned int numLights,
-                               const std::string& name, const PointLight* ptLights);
-    static void SetSpotLights(Shader& shader, const std::string& numName, const unsigned int numLights,
-                              const std::string& name, const SpotLight* spLights);
-};
\ No newline at end of file
+    LightBuffer();
+
+    LightBuffer(const LightBuffer&) = delete;
+    LightBuffer& operator=(const LightBuffer&) = delete;
+
+    void SetDirectionalLight(const DirectionalLight& directLight);
+    void DisableDirectionalLight();
+    void SetPointLight(const unsigned int index, const PointLight& ptLight);
+    void SetPointLights(const unsigned int numLights, const PointLight* ptLights);
+    void SetSpotLight(const unsigned int index, const SpotLight& spLight);
+    void SetSpotLights(const unsigned int numLights, const SpotLight* spLights);
+
+    void Upload();
+    void Bind(const unsigned int binding = LIGHTS_BINDING) const;
+
+    inline bool IsDirty() const {
+        return m_DirtyBegin < m_DirtyEnd;
+    }
+
+   private:
+    void write(void* dst, const void* src, const unsigned int size);
+};
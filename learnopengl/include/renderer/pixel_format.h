@@ -0,0 +1,20 @@
+#pragma once
+
+#include <common.h>
+
+#include <cstddef>
+
+/* PixelFormat describes how an 8-bit image with a given channel count is stored on the GPU */
+struct PixelFormat {
+    GLenum InternalFormat;
+    GLenum Format;
+    // Channels of the uploaded data, more than the source only when there is no matching format
+    int Channels;
+    // Maps the stored channels to the RGBA that shaders read
+    GLint Swizzle[4];
+};
+
+PixelFormat ChoosePixelFormat(const int channels, const bool srgb);
+
+// Expand 1, 2 or 3 channel pixels to RGBA, grey is replicated into RGB and missing alpha is opaque
+void ExpandToRGBA(const unsigned char* src, unsigned char* dst, const size_t texelCount, const int channels);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <common.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+const std::string DEFAULT_PROGRAM_CACHE_DIRECTORY = "cache/shaders";
+
+struct ProgramCacheStats {
+    unsigned int Hits = 0;
+    unsigned int Compiled = 0;
+    // Binaries that were found but rejected by the driver
+    unsigned int Rejected = 0;
+    double LoadMs = 0.0;
+    double CompileMs = 0.0;
+};
+
+class ProgramCacheInst {
+   public:
+    std::filesystem::path m_Directory = DEFAULT_PROGRAM_CACHE_DIRECTORY;
+    bool m_Enabled = true;
+    bool m_Initialized = false;
+    // Hash of the driver vendor, renderer and version strings, binaries never survive a driver change
+    uint64_t m_DriverHash = 0;
+    ProgramCacheStats m_Stats;
+};
+
+/* ProgramCache stores linked program binaries on disk, keyed by the program sources (including defines) and the
+ * driver, so that warm startups skip compiling and linking */
+class ProgramCache {
+   private:
+    static ProgramCacheInst s_Instance;
+
+   public:
+    static void SetDirectory(const std::filesystem::path& directory);
+    static void SetEnabled(bool enabled);
+
+    static uint64_t ComputeKey(const std::vector<std::string>& sources);
+    // Try to load the binary for the key into the program, false if there is none or the driver rejected it
+    static bool Load(uint64_t key, unsigned int program);
+    static void Store(uint64_t key, unsigned int program);
+
+    static void AddLoadTime(double ms);
+    static void AddCompileTime(double ms);
+    static void LogStats();
+
+    inline static bool IsEnabled() {
+        return s_Instance.m_Enabled;
+    }
+
+    inline static const ProgramCacheStats& GetStats() {
+        return s_Instance.m_Stats;
+    }
+
+   private:
+    static bool init();
+    static std::filesystem::path pathForKey(uint64_t key);
+};
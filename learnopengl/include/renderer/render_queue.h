@@ -0,0 +1,85 @@
+#pragma once
+
+#include <renderer/ibo.h>
+#include <renderer/renderer.h>
+#include <renderer/shader.h>
+#include <renderer/texture.h>
+#include <renderer/vao.h>
+#include <scene/mesh.h>
+#include <scene/model.h>
+
+#include <array>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <map>
+#include <vector>
+
+const unsigned int MAX_DRAW_TEXTURES = 4;
+
+/* DrawCommand is a single deferred draw packet. If IBO is null, Count vertices are drawn as arrays, otherwise Count
+ * indices from FirstIndex on (the whole IBO if Count is 0). Textures are bound to consecutive slots starting from 0,
+ * unless SourceMesh is set in which case the mesh sets up its own material. */
+struct DrawCommand {
+    const VertexArray* VAO = nullptr;
+    const IndexBuffer* IBO = nullptr;
+    unsigned int Count = 0;
+    unsigned int FirstIndex = 0;
+    int BaseVertex = 0;
+    Shader* Program = nullptr;
+    std::array<const Texture*, MAX_DRAW_TEXTURES> Textures = {};
+    const Mesh* SourceMesh = nullptr;
+    // Per-draw data, uploaded to "u_Model"
+    glm::mat4 Model = glm::mat4(1.0f);
+    // Coarse ordering bucket (0-15), lower passes are flushed first
+    unsigned int Pass = 0;
+    // Translucent draws go after opaque draws of the same pass and are sorted back-to-front
+    bool Translucent = false;
+};
+
+struct RenderQueueStats {
+    unsigned int DrawCalls = 0;
+    unsigned int ProgramSwitches = 0;
+    unsigned int MaterialSwitches = 0;
+};
+
+class RenderQueue {
+   private:
+    struct QueuedCommand {
+        DrawCommand Command;
+        unsigned int MaterialID;
+    };
+
+    std::vector<QueuedCommand> m_Commands;
+    std::vector<uint64_t> m_Keys, m_KeysTemp;
+    std::vector<unsigned int> m_Order, m_OrderTemp;
+
+    // Programs and materials are interned into small dense IDs so they fit in the sort key, reset on every flush
+    std::map<unsigned int, unsigned int> m_ProgramIDs;
+    std::map<std::array<uintptr_t, MAX_DRAW_TEXTURES + 1>, unsigned int> m_MaterialIDs;
+
+    glm::vec3 m_ViewPosition = glm::vec3(0.0f);
+    float m_FarPlane = 100.0f;
+    RenderQueueStats m_Stats;
+
+   public:
+    RenderQueue() {}
+
+    void SetView(const glm::vec3& viewPosition, const float farPlane);
+    void Submit(const DrawCommand& cmd);
+    void Submit(const Mesh& mesh, Shader& shader, const glm::mat4& model, const unsigned int pass = 0);
+    void Submit(const Model& model, Shader& shader, const glm::mat4& modelMatrix, const unsigned int pass = 0);
+    void Flush(const Renderer& renderer);
+
+    inline unsigned int GetSize() const {
+        return (unsigned int)m_Commands.size();
+    }
+
+    inline const RenderQueueStats& GetStats() const {
+        return m_Stats;
+    }
+
+   private:
+    uint64_t buildSortKey(const DrawCommand& cmd, const unsigned int materialID);
+    unsigned int internMaterial(const DrawCommand& cmd);
+    void radixSort();
+};
@@ -53,13 +53,27 @@ class Renderer {
    private:
    public:
     void Draw(const VertexArray& va, const IndexBuffer& ib) const;
+    void Draw(const VertexArray& va, const IndexBuffer& ib, const unsigned int count, const unsigned int firstIndex,
+              const int baseVertex) const;
     void Draw(const VertexArray& va, const unsigned int count) const;
+    void Draw(const VertexArray& va, const IndexBuffer& ib, const std::vector<GeometryRange>& ranges) const;
     void Draw(const Mesh& mesh, Shader& shader) const;
     void Draw(const Model& model, Shader& shader) const;
+    void DrawIndirect(const Model& model, Shader& shader, const unsigned int lod = 0) const;
+    void DrawCulled(const Model& model, Shader& shader, const glm::mat4& modelMatrix, const glm::mat4& viewProjection,
+                    const glm::vec3& cameraPosition) const;
     void DrawInstanced(const VertexArray& va, const IndexBuffer& ib, const unsigned int instances) const;
+    void DrawInstanced(const VertexArray& va, const IndexBuffer& ib, const unsigned int count,
+                       const unsigned int firstIndex, const int baseVertex, const unsigned int instances,
+                       const unsigned int baseInstance = 0) const;
     void DrawInstanced(const VertexArray& va, const unsigned int count, const unsigned int instances) const;
-    void DrawInstanced(const Mesh& mesh, Shader& shader, const unsigned int instances) const;
-    void DrawInstanced(const Model& model, Shader& shader, const unsigned int instances) const;
+    void DrawInstanced(const Mesh& mesh, Shader& shader, const unsigned int instances, const unsigned int lod = 0,
+                       const unsigned int baseInstance = 0) const;
+    void DrawInstanced(const Model& model, Shader& shader, const unsigned int instances, const unsigned int lod = 0,
+                       const unsigned int baseInstance = 0) const;
+    // Draws instances [baseInstance, baseInstance + instances) of the instanced attributes at the given level of detail
+    void DrawInstancedIndirect(const Model& model, Shader& shader, const unsigned int instances,
+                               const unsigned int lod = 0, const unsigned int baseInstance = 0) const;
     void Clear(ClearBit cb = ClearBit::All) const;
 
     void SetClearColor(const glm::vec4 color) const;
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <common.h>
+
+const unsigned int RING_BUFFER_REGIONS = 3;
+
+/* RingAllocation is a piece of the current ring region. Data is write-only mapped memory, Offset is the offset into
+ * the whole buffer to bind at. */
+struct RingAllocation {
+    void* Data = nullptr;
+    unsigned int Offset = 0;
+    unsigned int Size = 0;
+};
+
+/* DynamicRingBuffer is a persistently and coherently mapped buffer split into RING_BUFFER_REGIONS regions, one per frame
+ * in flight. Data written through an allocation is visible to the GPU without any further GL call, a fence per region
+ * makes sure the CPU never overwrites data the GPU may still read. */
+class DynamicRingBuffer {
+   private:
+    unsigned int m_ReferenceID;
+    unsigned int m_Target;
+    unsigned int m_RegionSize;
+    unsigned int m_Alignment;
+    unsigned char* m_Mapped;
+
+    unsigned int m_Region;
+    unsigned int m_Head;
+    GLsync m_Fences[RING_BUFFER_REGIONS];
+
+   public:
+    DynamicRingBuffer(unsigned int regionSize, unsigned int target = GL_UNIFORM_BUFFER);
+    ~DynamicRingBuffer();
+
+    DynamicRingBuffer(const DynamicRingBuffer&) = delete;
+    DynamicRingBuffer& operator=(const DynamicRingBuffer&) = delete;
+
+    // Move to the next region, waiting for the GPU if it is still reading from it
+    void BeginFrame();
+    // Fence the current region after all draws reading from it have been issued
+    void EndFrame();
+
+    RingAllocation Allocate(unsigned int size);
+    RingAllocation Write(const void* data, unsigned int size);
+    void BindRange(const RingAllocation& allocation, unsigned int binding) const;
+
+    inline unsigned int GetRegionSize() const {
+        return m_RegionSize;
+    }
+
+    inline unsigned int GetReferenceID() const {
+        return m_ReferenceID;
+    }
+};
@@ -1,33 +1,131 @@
 #pragma once
 
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
+
+/* HashUniformName is FNV-1a over the name, usable at compile time */
+constexpr uint32_t HashUniformName(std::string_view name) {
+    uint32_t hash = 2166136261u;
+    for (char c : name) {
+        hash = (hash ^ (uint32_t)(unsigned char)c) * 16777619u;
+    }
+    return hash;
+}
+
+/* UniformName is a uniform name together with its hash. For literals the hash is folded at compile time, the
+ * _uniform suffix guarantees it. */
+struct UniformName {
+    std::string_view Name;
+    uint32_t Hash;
+
+    constexpr UniformName(std::string_view name) : Name(name), Hash(HashUniformName(name)) {}
+    constexpr UniformName(const char *name) : UniformName(std::string_view(name)) {}
+    UniformName(const std::string &name) : UniformName(std::string_view(name)) {}
+};
+
+consteval UniformName operator""_uniform(const char *name, size_t length) {
+    return UniformName(std::string_view(name, length));
+}
+
+/* UniformHandle is a resolved uniform of one shader, setting it is a direct location write */
+struct UniformHandle {
+    int Location = -1;
+    unsigned int Index = 0;
+
+    inline bool IsValid() const {
+        return Location >= 0;
+    }
+};
+
+struct UniformInfo {
+    std::string Name;
+    int Location;
+    unsigned int Type;
+    int ArraySize;
+    // Whether the uniform was ever set, only tracked in debug builds
+    bool Set;
+};
+
+struct UniformBlockInfo {
+    std::string Name;
+    int Binding;
+    int Size;
+};
 
 class Shader {
    private:
     unsigned int m_ReferenceID;
-    std::unordered_map<std::string, int> m_UniformLocationCache;
+    // Compile and link are only checked when the program is first used, until then the stages are kept
+    mutable bool m_Pending;
+    mutable unsigned int m_PendingShaders[3];
+    uint64_t m_CacheKey;
+    // Seconds spent parsing and submitting the program, the blocking part of Wait is added to it
+    double m_SubmitTime;
+
+    // Active uniforms reflected after linking, plus names that were looked up but are not active
+    mutable std::vector<UniformInfo> m_Uniforms;
+    mutable std::unordered_map<uint32_t, unsigned int> m_UniformIndices;
+    mutable std::vector<UniformBlockInfo> m_UniformBlocks;
 
    public:
     Shader(const std::string &vertexFilePath, const std::string &fragmentFilePath,
-           const std::string &geometryFilePath = "");
+           const std::string &geometryFilePath = "", const std::vector<std::string> &defines = {});
     ~Shader();
 
     void Bind() const;
     void Unbind() const;
 
-    void SetUniform1f(const std::string &name, float value);
-    void SetUniform1i(const std::string &name, int value);
-    void SetUniform3f(const std::string &name, float v0, float v1, float v2);
-    void SetUniform3f(const std::string &name, glm::vec3 value);
-    void SetUniform4f(const std::string &name, float v0, float v1, float v2, float v3);
-    void SetUniform4f(const std::string &name, glm::vec4 value);
-    void SetUniformMatrix4f(const std::string &name, glm::mat4 value);
+    bool IsReady() const;
+    void Wait() const;
+
+    UniformHandle GetUniform(UniformName name);
+    int GetUniformBlockBinding(std::string_view name) const;
+    // Logs every active uniform that was never set, only available in debug builds
+    void ReportUnsetUniforms() const;
+
+    void SetUniform1f(UniformName name, float value);
+    void SetUniform1i(UniformName name, int value);
+    void SetUniform1iv(UniformName name, unsigned int count, const int *values);
+    void SetUniform3f(UniformName name, float v0, float v1, float v2);
+    void SetUniform3f(UniformName name, glm::vec3 value);
+    void SetUniform4f(UniformName name, float v0, float v1, float v2, float v3);
+    void SetUniform4f(UniformName name, glm::vec4 value);
+    void SetUniformMatrix4f(UniformName name, glm::mat4 value);
+
+    void SetUniform1f(UniformHandle handle, float value);
+    void SetUniform1i(UniformHandle handle, int value);
+    void SetUniform1iv(UniformHandle handle, unsigned int count, const int *values);
+    void SetUniform3f(UniformHandle handle, float v0, float v1, float v2);
+    void SetUniform3f(UniformHandle handle, glm::vec3 value);
+    void SetUniform4f(UniformHandle handle, float v0, float v1, float v2, float v3);
+    void SetUniform4f(UniformHandle handle, glm::vec4 value);
+    void SetUniformMatrix4f(UniformHandle handle, glm::mat4 value);
+
+    inline unsigned int GetReferenceID() const {
+        return m_ReferenceID;
+    }
+
+    inline const std::vector<UniformInfo> &GetUniforms() const {
+        Wait();
+        return m_Uniforms;
+    }
+
+    inline const std::vector<UniformBlockInfo> &GetUniformBlocks() const {
+        Wait();
+        return m_UniformBlocks;
+    }
 
    private:
-    int getUniformLocation(const std::string &name);
-    const std::string parseShader(const std::string &filepath);
+    void reflectUniforms() const;
+    unsigned int addUniform(const std::string &name, int location, unsigned int type, int arraySize) const;
+    void markSet(UniformHandle handle);
+    const std::string parseShader(const std::string &filepath, const std::vector<std::string> &defines);
     unsigned int compileShader(const unsigned int type, const std::string &sourceVal);
+    void checkShader(const unsigned int id) const;
     unsigned int createProgram(unsigned int vertexShader, unsigned int fragmentShader, unsigned int geometryShader);
+    void checkProgram(const unsigned int program) const;
 };
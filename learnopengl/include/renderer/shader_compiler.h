@@ -0,0 +1,53 @@
+#pragma once
+
+#include <common.h>
+
+#include <vector>
+
+// GL_KHR_parallel_shader_compile is not part of the generated loader
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+typedef void(APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+#endif
+
+// Let the driver pick the number of compiler threads
+const unsigned int DEFAULT_COMPILER_THREADS = 0xFFFFFFFF;
+
+class Shader;
+
+class ShaderCompilerInst {
+   public:
+    std::vector<const Shader*> m_Pending;
+    bool m_Initialized = false;
+    bool m_Parallel = false;
+    unsigned int m_MaxThreads = DEFAULT_COMPILER_THREADS;
+};
+
+/* ShaderCompiler tracks the programs whose compile and link was submitted but whose status was not queried yet. With
+ * GL_KHR_parallel_shader_compile the driver compiles them concurrently and readiness can be polled without blocking. */
+class ShaderCompiler {
+   private:
+    static ShaderCompilerInst s_Instance;
+
+   public:
+    // Enable parallel compilation, has to run before the first glCompileShader for it to apply to that shader
+    static void Init();
+    static void SetMaxThreads(unsigned int count);
+
+    static void Submit(const Shader* shader);
+    static void Remove(const Shader* shader);
+
+    // Finish every pending program, blocking until the driver is done with all of them
+    static void WaitAll();
+    // Whether all pending programs can be finished without blocking
+    static bool AllReady();
+
+    inline static unsigned int GetPendingCount() {
+        return (unsigned int)s_Instance.m_Pending.size();
+    }
+
+    inline static bool IsParallel() {
+        return s_Instance.m_Parallel;
+    }
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <renderer/shader.h>
+
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* VariantOption is one #define of a variant set taking the values 0 to Max. An option with Max 1 is defined without a
+ * value when set, any other option is always defined to its value. */
+struct VariantOption {
+    std::string Define;
+    unsigned int Max = 1;
+};
+
+/* ShaderVariants compiles the same sources with different #defines, each variant is selected by a key that packs the
+ * option values in mixed radix (each option takes Max + 1 key values) and is compiled once on first use */
+class ShaderVariants {
+   private:
+    std::string m_VertexFilePath, m_FragmentFilePath, m_GeometryFilePath;
+    std::vector<VariantOption> m_Options;
+    std::vector<uint32_t> m_Strides;
+    std::unordered_map<uint32_t, std::unique_ptr<Shader>> m_Variants;
+
+   public:
+    ShaderVariants(const std::string &vertexFilePath, const std::string &fragmentFilePath,
+                   const std::vector<VariantOption> &options, const std::string &geometryFilePath = "");
+
+    // Pack one value per option, in the order the options were given, throws if a value exceeds its option's Max
+    uint32_t MakeKey(std::initializer_list<unsigned int> values) const;
+    // Submit the variant for compilation without waiting for it
+    void Prepare(uint32_t key);
+    Shader &Get(uint32_t key);
+
+    inline unsigned int GetVariantCount() const {
+        return (unsigned int)m_Variants.size();
+    }
+
+   private:
+    std::vector<std::string> definesForKey(uint32_t key) const;
+};
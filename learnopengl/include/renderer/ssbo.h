@@ -0,0 +1,25 @@
+#pragma once
+
+class ShaderStorageBuffer {
+   private:
+    unsigned int m_ReferenceID;
+    unsigned int m_Size;
+
+   public:
+    ShaderStorageBuffer(const void* data, unsigned int size);
+    ~ShaderStorageBuffer();
+
+    void Bind() const;
+    void Unbind() const;
+
+    void BindBase(unsigned int binding = 0) const;
+    void InsertData(unsigned int offset, const void* data, unsigned int size) const;
+
+    inline unsigned int GetSize() const {
+        return m_Size;
+    }
+
+    inline unsigned int GetReferenceID() const {
+        return m_ReferenceID;
+    }
+};
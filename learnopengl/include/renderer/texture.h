@@ -37,6 +37,13 @@ enum class TextureType {
     DepthAttachment,
 };
 
+enum class TextureCompression {
+    // Keep block-compressed data of cooked textures, decoding it on the CPU only if the driver cannot sample it
+    Preferred,
+    // Always store uncompressed texels, block-compressed files are decoded on the CPU
+    Disabled,
+};
+
 struct TextureOptions {
     TextureMinFilter MinFilter = TextureMinFilter::NearestMipMapLinear;
     TextureMagFilter MagFilter = TextureMagFilter::Linear;
@@ -46,6 +53,9 @@ struct TextureOptions {
     bool GenerateMipMap = true;
     bool GammaCorrection = false;
     glm::vec4 BorderColor = glm::vec4(0.0f);
+    TextureCompression Compression = TextureCompression::Preferred;
+    // Keep only the mip levels requested through TextureStreamer resident, needs a cooked file with mips
+    bool Streamed = false;
 
     TextureOptions() {}
 
@@ -96,15 +106,30 @@ struct TextureOptions {
     }
 };
 
+class TextureLoader;
+class TextureStreamer;
+
 class Texture {
    private:
     unsigned int m_ReferenceID;
     std::string m_FilePath;
     int m_Width, m_Height, m_BPP;
     TextureType m_Type;
+    TextureOptions m_Options;
+    bool m_Loaded;
+    bool m_Async;
+    size_t m_GPUBytes;
+    // Frame of the last Bind(), see TextureCache
+    mutable unsigned long long m_LastUsedFrame;
+
+    friend class TextureLoader;
+    friend class TextureStreamer;
 
    public:
-    Texture(const std::string& filePath, const TextureType type, const TextureOptions& options);
+    // Prefers a cooked .ktx2 file next to filePath if there is one (see TextureCooker).
+    // Async textures start as a 1x1 placeholder and receive their image through TextureLoader::Update()
+    Texture(const std::string& filePath, const TextureType type, const TextureOptions& options,
+            const bool async = false);
     Texture(const unsigned int w, const unsigned int h, const unsigned int bpp, const TextureType type,
             const TextureOptions& options);
     ~Texture();
@@ -113,8 +138,10 @@ class Texture {
     Texture(const std::string& filePath, const TextureOptions& opts) : Texture(filePath, TextureType::Texture, opts) {}
     Texture(const std::string& filePath, const TextureType type) : Texture(filePath, type, TextureOptions()) {}
 
+    // Binding an evicted texture loads it again
     void Bind(const unsigned int slot = 0, const bool activate = true) const;
     void Unbind() const;
+    void Evict();
 
     inline int GetWidth() const {
         return m_Width;
@@ -131,6 +158,37 @@ class Texture {
     inline unsigned int GetReferenceID() const {
         return m_ReferenceID;
     }
+
+    inline bool IsLoaded() const {
+        return m_Loaded;
+    }
+
+    inline bool IsResident() const {
+        return m_ReferenceID != 0;
+    }
+
+    inline const std::string& GetFilePath() const {
+        return m_FilePath;
+    }
+
+    inline const TextureOptions& GetOptions() const {
+        return m_Options;
+    }
+
+    // Approximate GPU memory of the texture including its mip chain, only the resident levels for streamed textures
+    inline size_t GetGPUBytes() const {
+        return m_GPUBytes;
+    }
+
+    inline unsigned long long GetLastUsedFrame() const {
+        return m_LastUsedFrame;
+    }
+
+   private:
+    void load();
+    void loadKtx(const std::string& filePath);
+    void loadStreamed(const std::string& filePath);
+    void finishLoad(const int width, const int height, const int channels, const void* data);
 };
 
 class CubeMap {
@@ -138,9 +196,16 @@ class CubeMap {
     unsigned int m_ReferenceID;
     std::string m_FilePaths[6];
     TextureType m_Type;
+    TextureOptions m_Options;
+    bool m_Loaded;
+
+    friend class TextureLoader;
 
    public:
     CubeMap(const std::string filePaths[6], const TextureType = TextureType::Texture,
+            const TextureOptions& options = TextureOptions(), const bool async = false);
+    // Load a cube map cooked into a single KTX2 file
+    CubeMap(const std::string& filePath, const TextureType type = TextureType::Texture,
             const TextureOptions& options = TextureOptions());
     CubeMap(const unsigned int w, const unsigned int h, const TextureType type, const TextureOptions& options);
     ~CubeMap();
@@ -158,4 +223,11 @@ class CubeMap {
     inline unsigned int GetReferenceID() const {
         return m_ReferenceID;
     }
+
+    inline bool IsLoaded() const {
+        return m_Loaded;
+    }
+
+   private:
+    void finishLoad(const int width, const int height, const int channels, const void* data);
 };
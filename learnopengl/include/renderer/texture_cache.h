@@ -0,0 +1,55 @@
+#pragma once
+
+#include <common.h>
+#include <renderer/texture.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+const size_t DEFAULT_TEXTURE_BUDGET = 256 * 1024 * 1024;
+
+struct TextureCacheStats {
+    unsigned int Hits = 0;
+    unsigned int Misses = 0;
+    unsigned int Evictions = 0;
+    unsigned int Reloads = 0;
+};
+
+class TextureCacheInst {
+   public:
+    // Keyed by canonical path, type and options. Entries do not keep textures alive, their users do.
+    std::unordered_map<std::string, std::weak_ptr<Texture>> m_Entries;
+    size_t m_Budget = DEFAULT_TEXTURE_BUDGET;
+    unsigned long long m_Frame = 1;
+    TextureCacheStats m_Stats;
+};
+
+/* TextureCache shares textures loaded from files across the whole process. When the textures in use exceed the memory
+ * budget, the least recently bound ones release their GPU storage and are loaded again on their next Bind(). */
+class TextureCache {
+   private:
+    static TextureCacheInst s_Instance;
+
+   public:
+    static std::shared_ptr<Texture> Acquire(const std::string& filePath, const TextureType type = TextureType::Texture,
+                                            const TextureOptions& options = TextureOptions(), const bool async = false);
+
+    // Enforce the budget and start a new frame, called once per frame before drawing
+    static void Update();
+
+    static void SetBudget(size_t bytes);
+    static size_t GetResidentBytes();
+    static void NotifyReload(const Texture& texture);
+
+    inline static unsigned long long GetFrame() {
+        return s_Instance.m_Frame;
+    }
+
+    inline static const TextureCacheStats& GetStats() {
+        return s_Instance.m_Stats;
+    }
+
+   private:
+    static std::string makeKey(const std::string& filePath, const TextureType type, const TextureOptions& options);
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <common.h>
+#include <renderer/ktx.h>
+
+#include <string>
+#include <vector>
+
+enum class CookCompression {
+    None,
+    // BC1, or BC3 when the image has transparent texels
+    Color,
+    // BC5 with renormalized mips, shaders rebuild Z from the two stored channels
+    NormalMap,
+};
+
+struct CookOptions {
+    // Store rows bottom-up as OpenGL expects, cube map faces must not be flipped
+    bool Flip = true;
+    // Filter the mip chain in linear space and store the format as sRGB
+    bool Srgb = false;
+    bool GenerateMipMap = true;
+    CookCompression Compression = CookCompression::None;
+    // Fail cooking when the compressed full resolution image is below this PSNR in dB
+    double MinPSNR = 0.0;
+};
+
+/* TextureCooker converts source images into KTX2 containers holding the final format and mip chain, so that loading
+ * them needs no decode, flip or mip generation. Cooked files are written next to their source with a .ktx2 extension
+ * and are picked up by Texture automatically. */
+class TextureCooker {
+   public:
+    static bool Cook(const std::string& srcPath, const std::string& dstPath, const CookOptions& options = CookOptions());
+    static bool CookCubeMap(const std::string srcPaths[6], const std::string& dstPath,
+                            const CookOptions& options = CookOptions());
+
+    static std::string GetCookedPath(const std::string& srcPath);
+
+   private:
+    static bool cookFaces(const std::vector<std::string>& srcPaths, const std::string& dstPath,
+                          const CookOptions& options);
+    static bool loadImage(const std::string& filePath, const bool flip, std::vector<unsigned char>& pixels, int& width,
+                          int& height);
+    static void downsample(const std::vector<unsigned char>& src, const int width, const int height, const bool srgb,
+                           std::vector<unsigned char>& dst);
+    static void renormalize(std::vector<unsigned char>& pixels);
+    static BlockFormat chooseBlockFormat(const std::vector<std::vector<unsigned char>>& faces,
+                                         const CookOptions& options);
+    static KtxFormat getKtxFormat(const BlockFormat block, const bool srgb);
+    static const char* getBlockFormatName(const BlockFormat block);
+};
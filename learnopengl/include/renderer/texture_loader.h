@@ -0,0 +1,110 @@
+#pragma once
+
+#include <common.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+const unsigned int TEXTURE_UPLOAD_BUFFERS = 3;
+// Bytes uploaded per Update() call, at least one image is always uploaded
+const unsigned int DEFAULT_UPLOAD_BUDGET = 16 * 1024 * 1024;
+
+class Texture;
+class CubeMap;
+
+struct TextureLoadJob {
+    unsigned long long ID = 0;
+    std::string FilePath;
+    // Cube maps are split into one job per face so that the faces are decoded in parallel
+    unsigned int Face = 0;
+    bool Flip = false;
+    bool Srgb = false;
+    Texture* Target2D = nullptr;
+    CubeMap* TargetCube = nullptr;
+};
+
+struct DecodedImage {
+    TextureLoadJob Job;
+    // Allocated by stb_image, nullptr if the file failed to load
+    unsigned char* Pixels = nullptr;
+    int Width = 0, Height = 0, Channels = 0;
+};
+
+/* PendingCubeMap collects the decoded faces of a cube map until all six can be uploaded together */
+struct PendingCubeMap {
+    DecodedImage Faces[6];
+    unsigned int Decoded = 0;
+};
+
+struct TextureLoaderStats {
+    unsigned int Uploaded = 0;
+    unsigned int Failed = 0;
+    unsigned long long UploadedBytes = 0;
+};
+
+class TextureLoaderInst {
+   public:
+    std::vector<std::thread> m_Workers;
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::deque<TextureLoadJob> m_Jobs;
+    std::deque<DecodedImage> m_Decoded;
+    // Jobs that were submitted and not cancelled, as job ID -> owner
+    std::unordered_map<unsigned long long, const void*> m_Live;
+    unsigned long long m_NextID = 1;
+    bool m_Stop = false;
+
+    // Only touched by the GL thread
+    unsigned int m_PixelBuffers[TEXTURE_UPLOAD_BUFFERS] = {};
+    unsigned int m_NextPixelBuffer = 0;
+    unsigned int m_UploadBudget = DEFAULT_UPLOAD_BUDGET;
+    std::unordered_map<const CubeMap*, PendingCubeMap> m_CubeMaps;
+    TextureLoaderStats m_Stats;
+
+    ~TextureLoaderInst();
+    void Stop();
+};
+
+/* TextureLoader decodes images on a pool of worker threads and streams the pixels to the GL through pixel unpack
+ * buffers. Textures are usable right away with a placeholder texel and receive their image in a later Update(). */
+class TextureLoader {
+   private:
+    static TextureLoaderInst s_Instance;
+
+   public:
+    static void Submit(Texture* texture, const std::string& filePath);
+    static void Submit(CubeMap* cubeMap, const std::string filePaths[6]);
+    // Drop every job of the owner, called when a texture is destroyed before its upload
+    static void Cancel(const void* owner);
+
+    // Upload finished decodes on the GL thread, limited by the upload budget
+    static void Update();
+    // Block until every submitted texture is uploaded
+    static void WaitAll();
+    // Block until the textures of owner are uploaded, other textures may be uploaded meanwhile
+    static void Wait(const void* owner);
+
+    static void SetUploadBudget(unsigned int bytes);
+    static bool IsIdle();
+    // Join the workers and delete the pixel unpack buffers, called while the GL context is still current
+    static void Shutdown();
+
+    inline static const TextureLoaderStats& GetStats() {
+        return s_Instance.m_Stats;
+    }
+
+   private:
+    static void start();
+    static void submit(TextureLoadJob job, const void* owner);
+    static void workerLoop();
+    static bool isPending(const void* owner);
+    static void decode(DecodedImage& image);
+    static void addFace(DecodedImage& image);
+    static void upload(DecodedImage* images, unsigned int count);
+    static void release(DecodedImage& image);
+};
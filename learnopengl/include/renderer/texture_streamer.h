@@ -0,0 +1,126 @@
+#pragma once
+
+#include <common.h>
+#include <renderer/binding_cache.h>
+#include <renderer/ktx.h>
+
+#include <condition_variable>
+#include <deque>
+#include <glm/glm.hpp>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Levels at or below this size are always resident, so a streamed texture can be sampled at any time
+const unsigned int STREAMING_TAIL_SIZE = 64;
+// Texture unit used for level uploads so that the units of the frame being rendered are left alone
+const unsigned int STREAMING_TEXTURE_UNIT = MAX_CACHED_TEXTURE_UNITS - 1;
+// Frames a texture keeps its levels after it was last requested
+const unsigned int STREAMING_GRACE_FRAMES = 30;
+const size_t DEFAULT_STREAMING_BUDGET = 128 * 1024 * 1024;
+
+class Texture;
+
+/* StreamedFormat tells how the levels of a KTX2 file are defined on the GPU */
+struct StreamedFormat {
+    GLenum InternalFormat = 0;
+    // External format and type of uncompressed uploads
+    GLenum Format = 0;
+    GLenum Type = 0;
+    bool Compressed = false;
+    // Block-compressed levels the driver cannot sample, expanded to RGBA8 while reading
+    bool Decode = false;
+};
+
+/* StreamedTexture is the streaming state of one texture, levels [ResidentLevel, level count) are on the GPU */
+struct StreamedTexture {
+    Texture* Target = nullptr;
+    std::shared_ptr<KtxFile> File;
+    StreamedFormat Format;
+    unsigned int TailLevel = 0;
+    unsigned int ResidentLevel = 0;
+    // Finest level asked for by Request() since the last Update(), and the level kept until the grace period ends
+    unsigned int RequestedLevel = 0;
+    unsigned int WantedLevel = 0;
+    unsigned long long LastRequestFrame = 0;
+    // ID of the read in flight, 0 if there is none
+    unsigned long long PendingRead = 0;
+};
+
+/* StreamRead copies levels [FirstLevel, LastLevel) out of the file mapping on the I/O thread */
+struct StreamRead {
+    unsigned long long ID = 0;
+    Texture* Target = nullptr;
+    std::shared_ptr<KtxFile> File;
+    StreamedFormat Format;
+    unsigned int FirstLevel = 0, LastLevel = 0;
+    std::vector<std::vector<unsigned char>> Levels;
+};
+
+struct TextureStreamerStats {
+    unsigned int LevelsLoaded = 0;
+    unsigned int LevelsDropped = 0;
+    unsigned long long ResidentBytes = 0;
+    // Levels skipped on every texture to stay within the budget in the last Update()
+    unsigned int Bias = 0;
+};
+
+class TextureStreamerInst {
+   public:
+    std::thread m_Worker;
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::deque<StreamRead> m_Reads;
+    std::deque<StreamRead> m_Finished;
+    unsigned long long m_NextID = 1;
+    bool m_Stop = false;
+
+    // Only touched by the GL thread
+    std::unordered_map<const Texture*, StreamedTexture> m_Textures;
+    unsigned long long m_Frame = 1;
+    size_t m_Budget = DEFAULT_STREAMING_BUDGET;
+    TextureStreamerStats m_Stats;
+
+    ~TextureStreamerInst();
+};
+
+/* TextureStreamer keeps only the mip levels of cooked textures that are needed on screen. Every frame the scene
+ * requests a footprint per texture, Update() drops the levels that are finer than needed right away and reads the
+ * missing ones from the file on an I/O thread. The texture's base level always points at its finest resident level. */
+class TextureStreamer {
+   private:
+    static TextureStreamerInst s_Instance;
+
+   public:
+    // Called by Texture, uploads the levels of the tail and takes over level management of the texture
+    static void Register(Texture* texture, std::shared_ptr<KtxFile> file, const StreamedFormat& format);
+    static void Unregister(const Texture* texture);
+
+    // Ask for the levels needed to draw the texture over footprint pixels, the largest request of a frame wins
+    static void Request(const Texture& texture, float footprint);
+    // Screen height in pixels covered by a sphere, an upper bound for the size of a texture mapped onto it
+    static float ComputeFootprint(const glm::vec3& center, float radius, const glm::vec3& cameraPos, float fovY,
+                                  float viewportHeight);
+
+    // Apply finished reads, then fit the requests of the last frame into the budget. Runs on the GL thread.
+    static void Update();
+
+    static void SetBudget(size_t bytes);
+
+    inline static const TextureStreamerStats& GetStats() {
+        return s_Instance.m_Stats;
+    }
+
+   private:
+    static void start();
+    static void workerLoop();
+    static void read(StreamRead& streamRead);
+    static void apply(StreamRead& streamRead);
+    static void dropLevels(StreamedTexture& texture, unsigned int level);
+    static void setBaseLevel(StreamedTexture& texture, unsigned int level);
+    static void uploadLevel(const StreamedTexture& texture, unsigned int level, const unsigned char* data, size_t size);
+    static size_t levelBytes(const StreamedTexture& texture, unsigned int level);
+    static size_t residentBytes(const StreamedTexture& texture, unsigned int level);
+};
@@ -23,6 +23,18 @@ struct VertexBufferElement {
                 return 4;
             case GL_UNSIGNED_BYTE:
                 return 1;
+            case GL_BYTE:
+                return 1;
+            case GL_HALF_FLOAT:
+                return 2;
+            case GL_SHORT:
+                return 2;
+            case GL_UNSIGNED_SHORT:
+                return 2;
+            case GL_INT_2_10_10_10_REV:
+                return 4;
+            case GL_UNSIGNED_INT_2_10_10_10_REV:
+                return 4;
         }
 
         assert(false);
@@ -30,6 +42,10 @@ struct VertexBufferElement {
     }
 
     unsigned int GetTotalSize() const {
+        // The 4 components of packed types share one 32-bit word
+        if (type == GL_INT_2_10_10_10_REV || type == GL_UNSIGNED_INT_2_10_10_10_REV) {
+            return GetSizeOfType();
+        }
         return count * GetSizeOfType();
     }
 };
@@ -63,7 +79,14 @@ class VertexBufferLayout {
 
     template <>
     void Push<unsigned char>(unsigned int count) {
-        VertexBufferElement element = {count, GL_BYTE, false};
+        VertexBufferElement element = {count, GL_UNSIGNED_BYTE, false};
+        m_Elements.push_back(element);
+        m_Stride += element.GetTotalSize();
+    }
+
+    /* Push adds an attribute of any GL type, normalized integer types are read as floats in [-1, 1] or [0, 1] */
+    void Push(unsigned int type, unsigned int count, bool normalized = false) {
+        VertexBufferElement element = {count, type, normalized};
         m_Elements.push_back(element);
         m_Stride += element.GetTotalSize();
     }
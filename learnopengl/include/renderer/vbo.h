@@ -6,11 +6,14 @@ class VertexBuffer {
 
    public:
     VertexBuffer(const void* data, unsigned int size);
+    VertexBuffer(unsigned int size);
     ~VertexBuffer();
 
     void Bind() const;
     void Unbind() const;
 
+    void InsertData(unsigned int offset, const void* data, unsigned int size) const;
+
     inline unsigned int GetReferenceID() {
         return m_ReferenceID;
     }
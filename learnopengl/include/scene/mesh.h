@@ -1,11 +1,14 @@
 #pragma once
 
+#include <renderer/geometry_arena.h>
 #include <renderer/ibo.h>
 #include <renderer/shader.h>
 #include <renderer/texture.h>
 #include <renderer/vao.h>
 #include <renderer/vbo.h>
+#include <scene/meshlet.h>
 
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <memory>
 #include <vector>
@@ -16,32 +19,72 @@ struct Vertex {
     glm::vec2 TexCoord;
 };
 
+/* Mesh is a range of the shared geometry arena plus its material textures, vertices are packed on upload */
 class Mesh {
    private:
-    std::vector<Vertex> m_Vertices;
-    std::vector<unsigned int> m_Indices;
+    GeometryRange m_Geometry;
+    // Coarser levels of detail after the mesh itself, index ranges over the same vertices
+    std::vector<GeometryRange> m_Lods;
+    // Clusters of the full detail index range, indices relative to its first index
+    std::vector<Meshlet> m_Meshlets;
+    // Meshes created from a model range do not own their geometry, the model frees the whole block
+    bool m_OwnsGeometry;
     std::vector<std::shared_ptr<Texture>> m_Textures;
 
-    std::shared_ptr<VertexBuffer> m_VBO;
-    std::shared_ptr<VertexArray> m_VAO;
-    std::shared_ptr<IndexBuffer> m_IBO;
+    // Private VAO over the arena page, only created once instanced attributes are added
+    mutable std::shared_ptr<VertexArray> m_VAO;
 
    public:
-    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices,
+    Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
          std::vector<std::shared_ptr<Texture>> textures);
+    Mesh(const GeometryRange& geometry, std::vector<std::shared_ptr<Texture>> textures,
+         std::vector<GeometryRange> lods = {}, std::vector<Meshlet> meshlets = {});
+    ~Mesh();
+
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
 
     void SetupDraw(Shader& shader) const;
     void AddInstancedBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout) const;
+    void SetVertexArray(const std::shared_ptr<VertexArray>& vao) const;
+
+    // Append the index ranges of the meshlets that survive frustum and normal cone culling, neighbouring survivors are
+    // merged into one range. Frustum and camera are in the space of the mesh. Without meshlets the whole mesh is kept.
+    void CullMeshlets(const Frustum& frustum, const glm::vec3& cameraPosition,
+                      std::vector<GeometryRange>& visible) const;
+
+    static GeometryArena& GetArena();
+
+    inline const GeometryRange& GetGeometry() const {
+        return m_Geometry;
+    }
+
+    // Level 0 is the mesh itself, levels past the coarsest one return the coarsest
+    inline const GeometryRange& GetLod(unsigned int level) const {
+        return level == 0 || m_Lods.empty() ? m_Geometry : m_Lods[std::min(level, (unsigned int)m_Lods.size()) - 1];
+    }
+
+    inline unsigned int GetLodCount() const {
+        return (unsigned int)m_Lods.size() + 1;
+    }
+
+    inline const std::vector<Meshlet>& GetMeshlets() const {
+        return m_Meshlets;
+    }
 
     inline const VertexBuffer& GetVBO() const {
-        return *m_VBO;
+        return *m_Geometry.Page->VBO;
     }
 
     inline const VertexArray& GetVAO() const {
-        return *m_VAO;
+        return m_VAO ? *m_VAO : *m_Geometry.Page->VAO;
     }
 
     inline const IndexBuffer& GetIBO() const {
-        return *m_IBO;
+        return *m_Geometry.Page->IBO;
+    }
+
+    inline const std::vector<std::shared_ptr<Texture>>& GetTextures() const {
+        return m_Textures;
     }
 };
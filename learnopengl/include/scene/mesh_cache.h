@@ -0,0 +1,106 @@
+#pragma once
+
+#include <core/mapped_file.h>
+#include <renderer/texture.h>
+#include <scene/mesh.h>
+#include <scene/meshlet.h>
+#include <scene/vertex_packing.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Bumped whenever the layout of the file or of PackedVertex changes, older caches are rebuilt
+const unsigned int MESH_CACHE_VERSION = 6;
+
+/* MeshTexture is a material texture reference, the path is relative to the model directory */
+struct MeshTexture {
+    TextureType Type;
+    std::string Path;
+};
+
+/* MeshLod is a simplified index range over the vertices of a mesh, Error is the distance error in model units */
+struct MeshLod {
+    unsigned int FirstIndex = 0, IndexCount = 0;
+    float Error = 0.0f;
+};
+
+/* CachedMesh is one mesh of a model, as a range of the model's vertex and index streams */
+struct CachedMesh {
+    unsigned int BaseVertex = 0, VertexCount = 0;
+    unsigned int FirstIndex = 0, IndexCount = 0;
+    std::vector<MeshTexture> Textures;
+    // Coarser levels of detail after the mesh itself
+    std::vector<MeshLod> Lods;
+    // Clusters of the full detail triangles, for culling parts of the mesh
+    std::vector<Meshlet> Meshlets;
+};
+
+/* MeshCacheData is the processed form of an imported model, indices are relative to each mesh's base vertex. Vertices
+ * is what the import passes work on, only its packed form is cached and uploaded. */
+struct MeshCacheData {
+    std::vector<Vertex> Vertices;
+    std::vector<PackedVertex> PackedVertices;
+    std::vector<unsigned int> Indices;
+    std::vector<CachedMesh> Meshes;
+    float BoundingRadius = 0.0f;
+};
+
+/* MeshCacheFile reads a model cache through a memory mapping, the streams can be uploaded straight from the mapping.
+ * A missing, corrupt or outdated file is not an error, the model is imported again instead. */
+class MeshCacheFile {
+   private:
+    MappedFile m_File;
+    std::string m_FilePath;
+    bool m_Valid;
+    // Modification time of the source to write into the header on close, 0 if the header is up to date
+    int64_t m_RefreshTime;
+    const PackedVertex* m_Vertices;
+    const unsigned int* m_Indices;
+    unsigned int m_VertexCount, m_IndexCount;
+    float m_BoundingRadius;
+    std::vector<CachedMesh> m_Meshes;
+
+   public:
+    // Validates the cache against the source model, see IsValid()
+    MeshCacheFile(const std::string& filePath, const std::string& sourcePath);
+    ~MeshCacheFile();
+
+    MeshCacheFile(const MeshCacheFile&) = delete;
+    MeshCacheFile& operator=(const MeshCacheFile&) = delete;
+
+    inline bool IsValid() const {
+        return m_Valid;
+    }
+
+    inline const PackedVertex* GetVertices() const {
+        return m_Vertices;
+    }
+
+    inline unsigned int GetVertexCount() const {
+        return m_VertexCount;
+    }
+
+    inline const unsigned int* GetIndices() const {
+        return m_Indices;
+    }
+
+    inline unsigned int GetIndexCount() const {
+        return m_IndexCount;
+    }
+
+    inline const std::vector<CachedMesh>& GetMeshes() const {
+        return m_Meshes;
+    }
+
+    inline float GetBoundingRadius() const {
+        return m_BoundingRadius;
+    }
+
+   private:
+    bool parse(const std::string& filePath, const std::string& sourcePath);
+};
+
+// Cache file written next to the model, e.g. backpack.obj -> backpack.obj.meshcache
+std::string GetMeshCachePath(const std::string& sourcePath);
+bool WriteMeshCache(const std::string& filePath, const std::string& sourcePath, const MeshCacheData& data);
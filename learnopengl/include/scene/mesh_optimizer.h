@@ -0,0 +1,44 @@
+#pragma once
+
+#include <scene/mesh.h>
+
+#include <cstddef>
+#include <vector>
+
+// FIFO post-transform cache size assumed when ordering triangles and when measuring the result
+const unsigned int VERTEX_CACHE_SIZE = 16;
+// Largest ACMR increase, relative to the vertex cache order, accepted to get finer clusters for overdraw sorting
+const float OVERDRAW_THRESHOLD = 1.05f;
+
+struct VertexCacheStats {
+    // Vertex shader invocations with a FIFO cache of VERTEX_CACHE_SIZE
+    unsigned int Transformed = 0;
+    // Average cache miss ratio, transformed vertices per triangle (0.5 at best, 3 at worst)
+    float ACMR = 0.0f;
+    // Average transformed vertex ratio, transformed vertices per referenced vertex (1 at best)
+    float ATVR = 0.0f;
+};
+
+// All passes work on indexed triangle lists with indices in [0, vertexCount)
+VertexCacheStats AnalyzeVertexCache(const unsigned int* indices, const size_t indexCount,
+                                    const unsigned int vertexCount);
+
+// Merge vertices whose attributes are equal, or equal after rounding to multiples of epsilon when it is not 0. The
+// referenced unique vertices are moved to the front in order of first use and their count is returned.
+unsigned int WeldVertices(Vertex* vertices, const unsigned int vertexCount, unsigned int* indices,
+                          const size_t indexCount, const float epsilon = 0.0f);
+
+// Reorder triangles for the post-transform cache (Tipsify). clusters receives the first triangle of every run that
+// starts from a cold cache, these runs can be reordered without hurting the cache much.
+void OptimizeVertexCache(unsigned int* indices, const size_t indexCount, const unsigned int vertexCount,
+                         std::vector<unsigned int>& clusters);
+
+// Split the clusters further as long as the ACMR stays within threshold, then draw clusters that face outwards from
+// the mesh center first so that they occlude the rest
+void OptimizeOverdraw(unsigned int* indices, const size_t indexCount, const Vertex* vertices,
+                      const unsigned int vertexCount, const std::vector<unsigned int>& clusters,
+                      const float threshold = OVERDRAW_THRESHOLD);
+
+// Reorder vertices by first use in the index buffer, unreferenced vertices are moved to the end
+void OptimizeVertexFetch(Vertex* vertices, const unsigned int vertexCount, unsigned int* indices,
+                         const size_t indexCount);
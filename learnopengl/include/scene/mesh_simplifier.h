@@ -0,0 +1,20 @@
+#pragma once
+
+#include <scene/mesh.h>
+
+#include <cstddef>
+#include <vector>
+
+// Fraction of the triangles collapsed at most in one pass, the rest of the edges keep their neighbourhood untouched so
+// that collapses of one pass cannot interfere
+const float SIMPLIFY_PASS_RATIO = 0.25f;
+// Cosine of the largest rotation of a triangle normal accepted for one collapse, flips would otherwise creep in over
+// several passes
+const float SIMPLIFY_MIN_NORMAL_COS = 0.25f;
+
+// Simplify an indexed triangle list to at most targetIndexCount indices with quadric error edge collapses. Vertices are
+// collapsed onto neighbouring vertices, so result indexes the same vertices. Vertices on open borders and attribute
+// seams (several vertices at one position) are never moved. Returns the largest distance error of the collapses, in
+// model units, the simplification stops early once no more edges can be collapsed.
+float SimplifyMesh(const Vertex* vertices, const unsigned int vertexCount, const unsigned int* indices,
+                   const size_t indexCount, const size_t targetIndexCount, std::vector<unsigned int>& result);
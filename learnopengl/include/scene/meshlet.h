@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Declared in scene/mesh.h, which needs the meshlet types
+struct Vertex;
+
+// Meshlet limits, the common mesh shader limits so that the clusters could also feed a mesh shader
+const unsigned int MESHLET_MAX_VERTICES = 64;
+const unsigned int MESHLET_MAX_TRIANGLES = 124;
+
+/* Meshlet is a run of triangles of a mesh index range with its bounds. The normal cone contains the normals of all
+ * triangles, ConeCutoff is the sine of its half angle (1 if the cone cannot be used for culling). */
+struct Meshlet {
+    // Relative to the first index of the mesh
+    unsigned int FirstIndex, IndexCount;
+    glm::vec3 Center;
+    float Radius;
+    glm::vec3 ConeAxis;
+    float ConeCutoff;
+};
+static_assert(sizeof(Meshlet) == 40, "Meshlet is stored as is in the mesh cache");
+
+/* Frustum holds the 6 clip planes (normal, distance) with normals pointing inwards */
+struct Frustum {
+    glm::vec4 Planes[6];
+};
+
+// Split an indexed triangle list into consecutive runs of at most MESHLET_MAX_VERTICES unique vertices and
+// MESHLET_MAX_TRIANGLES triangles. The triangle order is kept, so an order optimized for the vertex cache gives compact
+// clusters.
+void BuildMeshlets(const Vertex* vertices, const unsigned int vertexCount, const unsigned int* indices,
+                   const size_t indexCount, std::vector<Meshlet>& meshlets);
+
+// Planes of the frustum of a clip space transform, in the space the matrix transforms from
+Frustum ExtractFrustum(const glm::mat4& matrix);
+
+// False if the meshlet is outside the frustum or all of its triangles face away from the camera, both in the space of
+// the mesh
+bool IsMeshletVisible(const Meshlet& meshlet, const Frustum& frustum, const glm::vec3& cameraPosition);
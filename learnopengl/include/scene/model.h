@@ -1,32 +1,139 @@
 #pragma once
 
 #include <assimp/scene.h>
+#include <renderer/indirect.h>
+#include <renderer/ssbo.h>
 #include <scene/mesh.h>
+#include <scene/mesh_cache.h>
+#include <scene/mesh_optimizer.h>
+#include <scene/mesh_simplifier.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <memory>
 #include <unordered_map>
 #include <vector>
 
+// Texture units available to a model drawn with a single multi-draw, must match the indirect shaders
+const unsigned int MAX_INDIRECT_TEXTURES = 16;
+// Shader storage binding of the per-draw material table read through gl_DrawID
+const unsigned int INDIRECT_MATERIAL_BINDING = 0;
+// Vertices or faces extracted by one import task
+const unsigned int IMPORT_CHUNK_SIZE = 16384;
+// Vertices of imported meshes are merged when their attributes round to the same multiple of this, 0 merges exact
+// duplicates only
+const float IMPORT_WELD_EPSILON = 0.0f;
+// Levels of detail of a mesh including the mesh itself, each simplified level targets LOD_TRIANGLE_RATIO of the
+// triangles of the previous one
+const unsigned int MAX_LOD_LEVELS = 5;
+const float LOD_TRIANGLE_RATIO = 0.5f;
+// Simplification stops adding levels once a level keeps more than this fraction of the previous level's triangles
+const float LOD_MIN_REDUCTION = 0.8f;
+// Largest simplification error, in pixels on screen, accepted when selecting a level of detail
+const float LOD_PIXEL_ERROR = 1.0f;
+
+/* ImportTask extracts a range of the vertices or faces of one mesh into the preallocated model streams */
+struct ImportTask {
+    const aiMesh* Mesh;
+    bool Faces;
+    unsigned int Begin, End;
+    // First vertex or index written by the task
+    unsigned int Offset;
+};
+
+/* IndirectMaterial is one entry of the material table, indices point into the texture units of its batch */
+struct IndirectMaterial {
+    int Diffuse;
+    int Specular;
+};
+
+/* IndirectBatch is one multi-draw over consecutive meshes of a model whose textures fit into MAX_INDIRECT_TEXTURES
+ * units. gl_DrawID restarts at every multi-draw, so each batch has its own material table. */
+struct IndirectBatch {
+    // One buffer per level of detail, with one command per mesh of the batch
+    std::vector<std::shared_ptr<IndirectBuffer>> Buffers;
+    std::shared_ptr<ShaderStorageBuffer> Materials;
+    std::vector<std::shared_ptr<Texture>> Textures;
+};
+
 class Model {
    private:
     std::vector<std::shared_ptr<Mesh>> m_Meshes;
-    std::unordered_map<std::string, std::shared_ptr<Texture>> m_LoadedTextures;
     std::string m_FilePath;
     std::filesystem::path m_Directory;
+    TextureOptions m_TextureOptions;
+    // Radius of a sphere around the model origin enclosing every vertex
+    float m_BoundingRadius;
+    // Largest simplification error of every level of detail over all meshes, relative to the bounding radius
+    std::vector<float> m_LodErrors;
+
+    // Contiguous block of the mesh arena holding the geometry of all meshes, drawn with one glMultiDrawElementsIndirect
+    // per batch
+    GeometryRange m_Geometry;
+    // Private VAO over the arena page, only created once instanced attributes are added
+    mutable std::shared_ptr<VertexArray> m_VAO;
+    std::vector<IndirectBatch> m_IndirectBatches;
 
    public:
-    Model(const std::string& filePath);
+    // Loads from the mesh cache next to filePath when it is up to date, otherwise imports with Assimp and writes it
+    Model(const std::string& filePath, const TextureOptions& textureOptions = TextureOptions());
+    ~Model();
+
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
 
-    void SetupDraw(Shader& shader) const;
+    // Binds the textures and the material table of one indirect batch
+    void SetupDraw(Shader& shader, unsigned int batch = 0) const;
     void AddInstancedBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout) const;
+    // Request the mip levels of all textures for a model covering footprint pixels on screen, see TextureStreamer
+    void StreamTextures(float footprint) const;
+    // Coarsest level of detail whose error stays below LOD_PIXEL_ERROR for a model covering footprint pixels on
+    // screen, see TextureStreamer::ComputeFootprint
+    unsigned int SelectLod(float footprint) const;
+    // Largest footprint at which the error of the level of detail stays below LOD_PIXEL_ERROR
+    float GetLodFootprint(unsigned int lod) const;
 
     inline std::vector<std::shared_ptr<Mesh>> GetMeshes() const {
         return m_Meshes;
     }
 
+    inline float GetBoundingRadius() const {
+        return m_BoundingRadius;
+    }
+
+    inline unsigned int GetLodCount() const {
+        return (unsigned int)m_LodErrors.size();
+    }
+
+    inline unsigned int GetIndirectBatchCount() const {
+        return (unsigned int)m_IndirectBatches.size();
+    }
+
+    inline const VertexArray& GetVAO() const {
+        return m_VAO ? *m_VAO : *m_Geometry.Page->VAO;
+    }
+
+    inline const IndexBuffer& GetIBO() const {
+        return *m_Geometry.Page->IBO;
+    }
+
+    inline IndirectBuffer& GetIndirectBuffer(unsigned int batch = 0, unsigned int lod = 0) const {
+        const std::vector<std::shared_ptr<IndirectBuffer>>& buffers = m_IndirectBatches[batch].Buffers;
+        return *buffers[std::min(lod, (unsigned int)buffers.size() - 1)];
+    }
+
    private:
-    void processNode(aiNode* node, const aiScene* scene);
-    std::shared_ptr<Mesh> processMesh(aiMesh* mesh, const aiScene* scene);
-    std::vector<std::shared_ptr<Texture>> loadMaterialTextures(aiMaterial* mat, aiTextureType type, TextureType tType);
+    void importModel(MeshCacheData& data);
+    void setupGeometry(const PackedVertex* vertices, unsigned int vertexCount, const unsigned int* indices,
+                       unsigned int indexCount, const std::vector<CachedMesh>& meshes);
+    void setupIndirect();
+    void addIndirectBatch(std::vector<std::vector<DrawElementsIndirectCommand>>& commands,
+                          std::vector<IndirectMaterial>& materials, std::vector<std::shared_ptr<Texture>>& textures);
+    void collectMeshes(aiNode* node, const aiScene* scene, std::vector<const aiMesh*>& meshes);
+    static float processTask(const ImportTask& task, MeshCacheData& data);
+    static VertexCacheStats optimizeMesh(CachedMesh& mesh, MeshCacheData& data);
+    static void buildLods(CachedMesh& mesh, const MeshCacheData& data, std::vector<unsigned int>& indices);
+    static void buildMeshlets(CachedMesh& mesh, const MeshCacheData& data);
+    std::vector<MeshTexture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, TextureType tType);
+    std::vector<std::shared_ptr<Texture>> acquireTextures(const std::vector<MeshTexture>& textures);
 };
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <scene/mesh.h>
+
+#include <cstddef>
+#include <cstdint>
+
+/* PackedVertex is the 16 byte GPU form of Vertex (32 bytes) used by the mesh arena. Positions are half floats padded
+ * to 4 components, normals are octahedral encoded into 2 snorm16 and texture coordinates are half floats. */
+struct PackedVertex {
+    uint16_t Position[4];
+    int16_t Normal[2];
+    uint16_t TexCoord[2];
+};
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex must be 16 bytes");
+
+// IEEE 754 binary16 conversions, rounding to nearest even
+uint16_t FloatToHalf(const float value);
+float HalfToFloat(const uint16_t value);
+
+// Octahedral mapping of a unit vector to 2 snorm16, the shaders decode it with octDecode()
+void EncodeOctahedral(const glm::vec3& normal, int16_t encoded[2]);
+glm::vec3 DecodeOctahedral(const int16_t encoded[2]);
+
+void PackVertices(const Vertex* vertices, const size_t vertexCount, PackedVertex* packed);
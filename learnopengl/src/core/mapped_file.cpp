@@ -0,0 +1,91 @@
+#include <common.h>
+#include <core/mapped_file.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& filePath) {
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    m_FileHandle = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        return;
+    }
+    m_MappingHandle = mapping;
+
+    m_Data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (m_Data) {
+        m_Size = (size_t)size.QuadPart;
+    }
+}
+
+void MappedFile::Close() {
+    if (m_Data) {
+        UnmapViewOfFile(m_Data);
+    }
+    if (m_MappingHandle) {
+        CloseHandle(m_MappingHandle);
+    }
+    if (m_FileHandle) {
+        CloseHandle(m_FileHandle);
+    }
+    m_Data = nullptr;
+    m_Size = 0;
+    m_MappingHandle = nullptr;
+    m_FileHandle = nullptr;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& filePath) {
+    int fd = open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            m_Data = (const unsigned char*)data;
+            m_Size = (size_t)st.st_size;
+        }
+    }
+
+    // The mapping keeps its own reference to the file
+    close(fd);
+}
+
+void MappedFile::Close() {
+    if (m_Data) {
+        munmap((void*)m_Data, m_Size);
+    }
+    m_Data = nullptr;
+    m_Size = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    Close();
+}
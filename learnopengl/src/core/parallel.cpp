@@ -0,0 +1,36 @@
+#include <core/parallel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace Parallel {
+
+unsigned int GetWorkerCount() {
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+
+void For(unsigned int count, const std::function<void(unsigned int)>& task) {
+    std::atomic<unsigned int> next = 0;
+    auto run = [&]() {
+        for (unsigned int i = next++; i < count; i = next++) {
+            task(i);
+        }
+    };
+
+    // No more threads than tasks, a single task runs on the calling thread only
+    std::vector<std::thread> workers;
+    unsigned int workerCount = count > 1 ? std::min(GetWorkerCount(), count - 1) : 0;
+    for (unsigned int i = 0; i < workerCount; i++) {
+        workers.emplace_back(run);
+    }
+
+    run();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+}  // namespace Parallel
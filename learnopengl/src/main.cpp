@@ -2,24 +2,36 @@
 #include <core/input.h>
 #include <core/time.h>
 #include <core/window.h>
+#include <renderer/binding_cache.h>
 #include <renderer/camera.h>
 #include <renderer/fbo.h>
 #include <renderer/ibo.h>
 #include <renderer/light.h>
+#include <renderer/program_cache.h>
 #include <renderer/rbo.h>
+#include <renderer/ring_buffer.h>
+#include <renderer/render_queue.h>
 #include <renderer/renderer.h>
 #include <renderer/shader.h>
+#include <renderer/shader_compiler.h>
+#include <renderer/shader_variants.h>
 #include <renderer/texture.h>
+#include <renderer/texture_cache.h>
+#include <renderer/texture_cooker.h>
+#include <renderer/texture_loader.h>
+#include <renderer/texture_streamer.h>
 #include <renderer/ubo.h>
 #include <renderer/vao.h>
 #include <renderer/vbo.h>
 #include <scene/model.h>
 
+#include <algorithm>
 #include <glm/gtc/matrix_inverse.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
-#include <map>
+#include <limits>
+#include <numeric>
 
 #define DEBUG
 
@@ -65,6 +77,14 @@ void processWindowInputs(Window& window) {
     }
 }
 
+// Variant options of phong.frag
+const std::vector<VariantOption> PHONG_VARIANT_OPTIONS = {
+    {"ENABLE_BLINN"},
+    {"ENABLE_DIR_LIGHT"},
+    {"NUM_PT_LIGHTS", MAX_POINT_LIGHTS},
+    {"NUM_SP_LIGHTS", MAX_SPOT_LIGHTS},
+};
+
 struct VertexData {
     std::shared_ptr<VertexArray> va;
     std::shared_ptr<VertexBuffer> vb;
@@ -286,7 +306,9 @@ int testLightsAndCubes(Window& window) {
     glm::vec3 lightPosition(1.2f, 1.0f, 2.0f);
 
     // Initialize shader
-    Shader objShader("data/shaders/phong.vert", "data/shaders/phong.frag");
+    ShaderVariants phongVariants("data/shaders/phong.vert", "data/shaders/phong.frag", PHONG_VARIANT_OPTIONS);
+    // Directional light, one point light and one spot light
+    Shader& objShader = phongVariants.Get(phongVariants.MakeKey({0, 1, 1, 1}));
     Shader lightShader("data/shaders/basic.vert", "data/shaders/light.frag");
 
     // Initialize and set texture in shader
@@ -333,11 +355,21 @@ int testLightsAndCubes(Window& window) {
     lightShader.Bind();
     lightShader.SetUniform3f("u_LightColor", pointLights[0].Inner.Color);
 
-    // Set light uniforms
+    // Set light uniform block
+    LightBuffer lights;
+    lights.SetDirectionalLight(dirLight);
+    lights.SetPointLights(1, pointLights);
+    lights.SetSpotLights(1, spotLights);
+    lights.Upload();
+    lights.Bind();
+
     objShader.Bind();
-    Lighting::SetDirectionalLight(objShader, "u_DirLight", dirLight);
-    Lighting::SetPointLights(objShader, "u_NumPtLights", 1, "u_PtLights", pointLights);
-    Lighting::SetSpotLights(objShader, "u_NumSpLights", 1, "u_SpLights", spotLights);
+    // Per-frame uniforms are resolved once up front
+    UniformHandle objProjection = objShader.GetUniform("u_Projection"_uniform);
+    UniformHandle objView = objShader.GetUniform("u_View"_uniform);
+    UniformHandle objViewPos = objShader.GetUniform("u_ViewPos"_uniform);
+    UniformHandle objModel = objShader.GetUniform("u_Model"_uniform);
+    UniformHandle objInvTModel = objShader.GetUniform("u_InvTModel"_uniform);
     // Set object material (diffuse and specular are texture indices)
     objShader.SetUniform1f("u_Material.shininess", 32.0f);
     objShader.SetUniform1i("u_Material.diffuse", 0);
@@ -396,15 +428,19 @@ int testLightsAndCubes(Window& window) {
 
         {
             // Set light stuff
+            pointLights[0].Position = lightPosition;
+            spotLights[0].Position = camera.GetPosition();
+            spotLights[0].Direction = camera.GetFront();
+            lights.SetPointLight(0, pointLights[0]);
+            lights.SetSpotLight(0, spotLights[0]);
+            lights.Upload();
+
             objShader.Bind();
-            objShader.SetUniform3f("u_PtLights[0].position", lightPosition);
-            objShader.SetUniform3f("u_SpLights[0].position", camera.GetPosition());
-            objShader.SetUniform3f("u_SpLights[0].direction", camera.GetFront());
 
             // Drawing objects
-            objShader.SetUniformMatrix4f("u_Projection", projection);
-            objShader.SetUniformMatrix4f("u_View", view);
-            objShader.SetUniform3f("u_ViewPos", camera.GetPosition());
+            objShader.SetUniformMatrix4f(objProjection, projection);
+            objShader.SetUniformMatrix4f(objView, view);
+            objShader.SetUniform3f(objViewPos, camera.GetPosition());
 
             for (unsigned int i = 0; i < 10; i++) {
                 // Model matrix
@@ -412,8 +448,8 @@ int testLightsAndCubes(Window& window) {
                 model = glm::translate(model, cubePositions[i]);
                 float angle = 20.0f * (i + 1);
                 model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-                objShader.SetUniformMatrix4f("u_Model", model);
-                objShader.SetUniformMatrix4f("u_InvTModel", glm::inverseTranspose(model));
+                objShader.SetUniformMatrix4f(objModel, model);
+                objShader.SetUniformMatrix4f(objInvTModel, glm::inverseTranspose(model));
 
                 // Draw elements
                 renderer.Draw(objVA, objIB);
@@ -446,6 +482,7 @@ int testBackpackModel(Window& window) {
     int nbFrames = 0;
 
     Model backpack("data/models/backpack/backpack.obj");
+    RenderQueue renderQueue;
     // Shader bpShader("data/shaders/basic.vert", "data/shaders/basic.frag");
     Shader bpShader("data/shaders/explode.vert", "data/shaders/basic.frag", "data/shaders/explode.geom");
     Shader normShader("data/shaders/normal_viz.vert", "data/shaders/normal_viz.frag", "data/shaders/normal_viz.geom");
@@ -453,6 +490,10 @@ int testBackpackModel(Window& window) {
 
     // Rendering loop
     while (!window.ShouldClose()) {
+        // Upload textures decoded since the last frame and keep shared textures within the memory budget
+        TextureLoader::Update();
+        TextureCache::Update();
+
         // Clear screen
         renderer.Clear();
         processWindowInputs(window);
@@ -463,7 +504,10 @@ int testBackpackModel(Window& window) {
             // Framerate calculation
             nbFrames++;
             if (currentTime - lastTimeF >= 1.0) {
-                spdlog::debug("{} ms/frame, {} fps", 1000.0 / double(nbFrames), nbFrames);
+                const BindingStats& bindings = BindingCache::GetStats();
+                spdlog::debug("{} ms/frame, {} fps, {} of {} binds/frame elided", 1000.0 / double(nbFrames), nbFrames,
+                              bindings.Hits / nbFrames, (bindings.Hits + bindings.Misses) / nbFrames);
+                BindingCache::ResetStats();
                 nbFrames = 0;
                 lastTimeF += 1.0;
             }
@@ -488,8 +532,9 @@ int testBackpackModel(Window& window) {
             bpShader.Bind();
             bpShader.SetUniformMatrix4f("u_Projection", projection);
             bpShader.SetUniformMatrix4f("u_View", view);
-            bpShader.SetUniformMatrix4f("u_Model", model);
-            renderer.Draw(backpack, bpShader);
+            renderQueue.SetView(camera.GetPosition(), 100.0f);
+            renderQueue.Submit(backpack, bpShader, model);
+            renderQueue.Flush(renderer);
         }
 
         /*
@@ -610,7 +655,13 @@ int testDepthTestScene(Window& window) {
 
     Shader normalShader("data/shaders/depth.vert", "data/shaders/depth.frag");
     Shader singleColorShader("data/shaders/depth.vert", "data/shaders/single_color.frag");
-    Shader screenShader("data/shaders/screen.vert", "data/shaders/screen.frag");
+    // Post-processing effect is a compile-time variant of the screen shader, cycled with E
+    const unsigned int NUM_SCREEN_EFFECTS = 7;
+    ShaderVariants screenVariants("data/shaders/screen.vert", "data/shaders/screen.frag",
+                                  {{"SCREEN_EFFECT", NUM_SCREEN_EFFECTS - 1}});
+    unsigned int screenEffect = 0;
+    // The sampler unit never changes, it is only set when a variant is first used
+    std::vector<bool> screenEffectReady(NUM_SCREEN_EFFECTS, false);
 
     VertexBufferLayout layout;
     layout.Push<float>(3);
@@ -655,8 +706,6 @@ int testDepthTestScene(Window& window) {
     if (!fbo.IsComplete()) {
         spdlog::warn("[FrameBuffer Warn] FrameBuffer incomplete");
     }
-    screenShader.Bind();
-    screenShader.SetUniform1i("u_ScreenTexture", 0);
 
     // Load all the textures
     Texture cubeTex("data/textures/container.jpg");
@@ -691,6 +740,7 @@ int testDepthTestScene(Window& window) {
     // Frustum clipping planes
     const float nearPlane = 0.1f;
     const float farPlane = 100.0f;
+    RenderQueue renderQueue;
     // normalShader.SetUniform1f("u_Near", nearPlane);
     // normalShader.SetUniform1f("u_Far", farPlane);
 
@@ -714,15 +764,20 @@ int testDepthTestScene(Window& window) {
         normalShader.SetUniformMatrix4f("u_View", view);
         normalShader.SetUniformMatrix4f("u_Projection", projection);
 
+        renderQueue.SetView(camera.GetPosition(), farPlane);
+
         {
             // Make sure we don't update stencil buffer while drawing floor
             // renderer.SetStencilMask(0x00);
 
             // Draw floor
-            floorTex.Bind(0);
-            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, 0.0f, 0.0f));
-            normalShader.SetUniformMatrix4f("u_Model", model);
-            renderer.Draw(planeVAO, 6);
+            DrawCommand cmd;
+            cmd.VAO = &planeVAO;
+            cmd.Count = 6;
+            cmd.Program = &normalShader;
+            cmd.Textures[0] = &floorTex;
+            cmd.Model = glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, 0.0f, 0.0f));
+            renderQueue.Submit(cmd);
         }
 
         {
@@ -732,15 +787,16 @@ int testDepthTestScene(Window& window) {
             renderer.SetStencilMask(0xFF);
 
             // Draw cubes
-            cubeTex.Bind(0);
-            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(-1.0f, 0.0f, -1.0f));
-            normalShader.SetUniformMatrix4f("u_Model", model);
-            renderer.Draw(cubeVAO, 36);
-
-            model = glm::mat4(1.0f);
-            model = glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, 0.0f, 0.0f));
-            normalShader.SetUniformMatrix4f("u_Model", model);
-            renderer.Draw(cubeVAO, 36);
+            DrawCommand cmd;
+            cmd.VAO = &cubeVAO;
+            cmd.Count = 36;
+            cmd.Program = &normalShader;
+            cmd.Textures[0] = &cubeTex;
+            cmd.Model = glm::translate(glm::mat4(1.0f), glm::vec3(-1.0f, 0.0f, -1.0f));
+            renderQueue.Submit(cmd);
+
+            cmd.Model = glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, 0.0f, 0.0f));
+            renderQueue.Submit(cmd);
         }
 
         /*
@@ -781,23 +837,22 @@ int testDepthTestScene(Window& window) {
         */
 
         {
-            // Note: Always draw transparent objects after opaque objects
-            // Sort windows based on distance from camera
-            std::map<float, glm::vec3> sortedWPs;
+            // Windows are translucent, so the queue draws them after all opaque objects and in reverse-order
+            // (furthest from camera first)
+            DrawCommand cmd;
+            cmd.VAO = &windowVAO;
+            cmd.Count = 6;
+            cmd.Program = &normalShader;
+            cmd.Textures[0] = &windowTex;
+            cmd.Translucent = true;
             for (unsigned int i = 0; i < windowPositions.size(); i++) {
-                float distance = glm::length(camera.GetPosition() - windowPositions[i]);
-                sortedWPs[distance] = windowPositions[i];
-            }
-
-            // Draw window after all opaque objects and in reverse-order (furthest from camera first)
-            windowTex.Bind(0);
-            for (std::map<float, glm::vec3>::reverse_iterator it = sortedWPs.rbegin(); it != sortedWPs.rend(); ++it) {
-                glm::mat4 model = glm::translate(glm::mat4(1.0f), it->second);
-                normalShader.SetUniformMatrix4f("u_Model", model);
-                renderer.Draw(windowVAO, 6);
+                cmd.Model = glm::translate(glm::mat4(1.0f), windowPositions[i]);
+                renderQueue.Submit(cmd);
             }
         }
 
+        renderQueue.Flush(renderer);
+
         {
             fbo.Unbind();
             // Disable depth testing so that screen quad isn't discarded due to depth test
@@ -807,8 +862,17 @@ int testDepthTestScene(Window& window) {
             renderer.SetClearColor(1.0f, 1.0f, 1.0f, 1.0f);
             renderer.Clear(ClearBit::Color);
 
+            if (Input::IsKeyJustPressed(Key::E)) {
+                screenEffect = (screenEffect + 1) % NUM_SCREEN_EFFECTS;
+            }
+            Shader& screenShader = screenVariants.Get(screenVariants.MakeKey({screenEffect}));
+
             screenTex.Bind(0);
             screenShader.Bind();
+            if (!screenEffectReady[screenEffect]) {
+                screenShader.SetUniform1i(screenShader.GetUniform("u_ScreenTexture"_uniform), 0);
+                screenEffectReady[screenEffect] = true;
+            }
             renderer.Draw(quadVAO, 6);
             renderer.Draw(smallerQuadVAO, 6);
 
@@ -887,9 +951,10 @@ int testSkyBox(Window& window) {
         "data/textures/skybox/right.jpg",  "data/textures/skybox/left.jpg",  "data/textures/skybox/top.jpg",
         "data/textures/skybox/bottom.jpg", "data/textures/skybox/front.jpg", "data/textures/skybox/back.jpg",
     };
-    CubeMap skyboxMap(faces,
+    CubeMap skyboxMap(faces, TextureType::Texture,
                       TextureOptions(TextureMinFilter::Linear, TextureMagFilter::Linear, TextureWrap::ClampToEdge,
-                                     TextureWrap::ClampToEdge, TextureWrap::ClampToEdge));
+                                     TextureWrap::ClampToEdge, TextureWrap::ClampToEdge),
+                      true);
     Model backpack("data/models/backpack/backpack.obj");
 
     Shader bpShader("data/shaders/env_mapping.vert", "data/shaders/env_mapping.frag");
@@ -909,6 +974,10 @@ int testSkyBox(Window& window) {
 
     // Rendering loop
     while (!window.ShouldClose()) {
+        // Upload textures decoded since the last frame and keep shared textures within the memory budget
+        TextureLoader::Update();
+        TextureCache::Update();
+
         // Frame-time related calculations
         double currentTime = Time::GetTime();
         deltaTime = currentTime - lastTime;
@@ -939,8 +1008,11 @@ int testSkyBox(Window& window) {
             bpShader.SetUniformMatrix4f("u_InvTModel", glm::inverseTranspose(model));
             bpShader.SetUniform3f("u_CameraPos", camera.GetPosition());
 
+            // Only the meshlets facing the camera inside the frustum are drawn, which relies on back face culling
             skyboxMap.Bind();
-            renderer.Draw(backpack, bpShader);
+            renderer.SetFaceCulling(true);
+            renderer.DrawCulled(backpack, bpShader, model, projection * view, camera.GetPosition());
+            renderer.SetFaceCulling(false);
         }
 
         {
@@ -1025,9 +1097,8 @@ int testUniformBuffer(Window& window) {
     cubeVAO.AddBuffer(cubeVBO, layout);
 
     // Uniform buffers are shared across all shaders!
-    UniformBuffer matricesUBO(3 * sizeof(glm::mat4));
-    // This binding corresponds to the binding that is written in the shader (binding = 2)
-    matricesUBO.BindRange(0, 3 * sizeof(glm::mat4), 2);
+    // Every cube gets its own copy of the matrices block, written straight into persistently mapped memory
+    DynamicRingBuffer matricesRing(64 * 1024);
 
     // Camera
     Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
@@ -1054,24 +1125,28 @@ int testUniformBuffer(Window& window) {
         processWindowInputs(window);
         processCameraInputs(camera, (float)deltaTime);
 
+        matricesRing.BeginFrame();
         {
             // Projection matrix
             glm::mat4 projection = glm::perspective(glm::radians(camera.GetZoom()), aspectRatio, 0.1f, 100.0f);
-            matricesUBO.InsertData(0, glm::value_ptr(projection), sizeof(glm::mat4));
             // View matrix
             glm::mat4 view = camera.ViewMatrix();
-            matricesUBO.InsertData(sizeof(glm::mat4), glm::value_ptr(view), sizeof(glm::mat4));
-        }
 
-        {
             // Draw cubes
             for (unsigned int i = 0; i < 8; i += 2) {
-                glm::mat4 model = glm::translate(glm::mat4(1.0f), positionsAndColors[i]);
-                matricesUBO.InsertData(2 * sizeof(glm::mat4), glm::value_ptr(model), sizeof(glm::mat4));
+                RingAllocation matrices = matricesRing.Allocate(3 * sizeof(glm::mat4));
+                glm::mat4* block = (glm::mat4*)matrices.Data;
+                block[0] = projection;
+                block[1] = view;
+                block[2] = glm::translate(glm::mat4(1.0f), positionsAndColors[i]);
+                // This binding corresponds to the binding that is written in the shader (binding = 2)
+                matricesRing.BindRange(matrices, 2);
+
                 shader.SetUniform4f("u_Color", glm::vec4(positionsAndColors[i + 1], 1.0f));
                 renderer.Draw(cubeVAO, 36);
             }
         }
+        matricesRing.EndFrame();
 
         window.SwapBuffers();
         window.PollEvents();
@@ -1137,11 +1212,17 @@ int testInstancedQuads(Window& window) {
     return 0;
 }
 
+// Shader storage bindings of asteroid_indirect.vert, binding 0 is the indirect material table
+const unsigned int ASTEROID_MATRIX_BINDING = 1;
+const unsigned int ASTEROID_INDEX_BINDING = 2;
+
 int testInstancedAsteroids(Window& window) {
     float aspectRatio = (float)window.GetWidth() / (float)window.GetHeight();
 
     unsigned int amount = 100000;
     glm::mat4* modelMatrices = new glm::mat4[amount];
+    // Position and scale of every asteroid, used for texture streaming and to select its level of detail
+    std::vector<glm::vec4> asteroidBounds(amount);
     srand(glfwGetTime());  // initialize random seed
     float radius = 150.0;
     float offset = 25.0f;
@@ -1168,18 +1249,23 @@ int testInstancedAsteroids(Window& window) {
 
         // 4. now add to list of matrices
         modelMatrices[i] = model;
+        asteroidBounds[i] = glm::vec4(x, y, z, scale);
     }
 
     // Model
-    Model planet("data/models/planet/planet.obj");
-    Model asteroid("data/models/asteroid/rock.obj");
-
-    VertexBuffer instanceVBO(modelMatrices, amount * sizeof(glm::mat4));
-    VertexBufferLayout instanceLayout;
-    for (unsigned int i = 0; i < 4; i++) {
-        instanceLayout.Push<float>(4);
-    }
-    asteroid.AddInstancedBuffer(instanceVBO, instanceLayout);
+    // Cooked textures of both models only keep the mip levels needed for their size on screen
+    TextureOptions streamedOptions;
+    streamedOptions.Streamed = true;
+    Model planet("data/models/planet/planet.obj", streamedOptions);
+    Model asteroid("data/models/asteroid/rock.obj", streamedOptions);
+
+    // The matrices are uploaded once. Instances are grouped by level of detail every frame, each group is drawn from
+    // its own range of the instance index buffer, which the vertex shader reads the matrix through.
+    ShaderStorageBuffer instanceMatrices(modelMatrices, amount * (unsigned int)sizeof(glm::mat4));
+    ShaderStorageBuffer instanceIndices(nullptr, amount * (unsigned int)sizeof(unsigned int));
+    std::vector<unsigned int> sortedIndices(amount);
+    std::vector<unsigned int> asteroidLods(amount, MAX_LOD_LEVELS);
+    std::vector<unsigned int> lodOffsets(asteroid.GetLodCount() + 1);
 
     // Camera
     Camera camera(glm::vec3(0.0f, 10.0f, 155.0f));
@@ -1187,8 +1273,9 @@ int testInstancedAsteroids(Window& window) {
     double lastTime = 0.0;   // Time of last frame
 
     // Shader
-    Shader planetShader("data/shaders/basic.vert", "data/shaders/basic.frag");
-    Shader asteroidShader("data/shaders/asteroid.vert", "data/shaders/basic.frag");
+    // Both models are drawn with a single multi-draw each, reading their materials through gl_DrawID
+    Shader planetShader("data/shaders/basic_indirect.vert", "data/shaders/basic_indirect.frag");
+    Shader asteroidShader("data/shaders/asteroid_indirect.vert", "data/shaders/basic_indirect.frag");
 
     Renderer renderer;
     renderer.SetDepthTest(true);
@@ -1198,6 +1285,11 @@ int testInstancedAsteroids(Window& window) {
     int nbFrames = 0;
 
     while (!window.ShouldClose()) {
+        // Upload textures decoded since the last frame and keep shared textures within the memory budget
+        TextureLoader::Update();
+        TextureCache::Update();
+        TextureStreamer::Update();
+
         double currentTime = Time::GetTime();
         // View matrix (reverse direction of where camera moves)
         deltaTime = currentTime - lastTime;
@@ -1221,6 +1313,63 @@ int testInstancedAsteroids(Window& window) {
         glm::mat4 projection = glm::perspective(glm::radians(camera.GetZoom()), aspectRatio, 0.1f, 1000.0f);
         glm::mat4 view = camera.ViewMatrix();
 
+        {
+            // Request texture levels for the planet and for the asteroid closest to covering the screen
+            float fovY = glm::radians(camera.GetZoom());
+            float viewportHeight = (float)window.GetHeight();
+            planet.StreamTextures(TextureStreamer::ComputeFootprint(glm::vec3(0.0f, -3.0f, 0.0f),
+                                                                    planet.GetBoundingRadius() * 4.0f,
+                                                                    camera.GetPosition(), fovY, viewportHeight));
+
+            // The footprint grows with radius / distance, so SelectLod turns into a largest squared ratio per level
+            // and only the asteroid with the largest ratio needs its footprint for streaming
+            std::vector<float> lodRatios(asteroid.GetLodCount(), std::numeric_limits<float>::max());
+            for (unsigned int lod = 0; lod < lodRatios.size(); lod++) {
+                float footprint = asteroid.GetLodFootprint(lod);
+                if (footprint < std::numeric_limits<float>::max()) {
+                    // Squared sine of the angle subtended at the footprint, see TextureStreamer::ComputeFootprint
+                    float tanAngle = footprint * std::tan(fovY * 0.5f) / viewportHeight;
+                    lodRatios[lod] = tanAngle * tanAngle / (1.0f + tanAngle * tanAngle);
+                }
+            }
+
+            unsigned int nearest = 0;
+            float nearestRatio = 0.0f;
+            bool lodsChanged = false;
+            std::fill(lodOffsets.begin(), lodOffsets.end(), 0);
+            for (unsigned int i = 0; i < amount; i++) {
+                const glm::vec4& bounds = asteroidBounds[i];
+                glm::vec3 toCamera = glm::vec3(bounds) - camera.GetPosition();
+                float radius = asteroid.GetBoundingRadius() * bounds.w;
+                float ratio = radius * radius / glm::dot(toCamera, toCamera);
+                if (ratio > nearestRatio) {
+                    nearest = i;
+                    nearestRatio = ratio;
+                }
+
+                unsigned int lod = 0;
+                while (lod + 1 < lodRatios.size() && ratio <= lodRatios[lod + 1]) {
+                    lod++;
+                }
+                lodsChanged |= lod != asteroidLods[i];
+                asteroidLods[i] = lod;
+                lodOffsets[lod + 1]++;
+            }
+            asteroid.StreamTextures(TextureStreamer::ComputeFootprint(
+                glm::vec3(asteroidBounds[nearest]), asteroid.GetBoundingRadius() * asteroidBounds[nearest].w,
+                camera.GetPosition(), fovY, viewportHeight));
+
+            // Counting sort of the instance indices by level, only uploaded when any instance changed its level
+            std::partial_sum(lodOffsets.begin(), lodOffsets.end(), lodOffsets.begin());
+            if (lodsChanged) {
+                std::vector<unsigned int> next(lodOffsets.begin(), lodOffsets.end() - 1);
+                for (unsigned int i = 0; i < amount; i++) {
+                    sortedIndices[next[asteroidLods[i]]++] = i;
+                }
+                instanceIndices.InsertData(0, sortedIndices.data(), amount * (unsigned int)sizeof(unsigned int));
+            }
+        }
+
         {
             // Draw planet
             glm::mat4 model = glm::mat4(1.0f);
@@ -1231,15 +1380,22 @@ int testInstancedAsteroids(Window& window) {
             planetShader.SetUniformMatrix4f("u_Projection", projection);
             planetShader.SetUniformMatrix4f("u_View", view);
             planetShader.SetUniformMatrix4f("u_Model", model);
-            renderer.Draw(planet, planetShader);
+            renderer.DrawIndirect(planet, planetShader);
         }
 
         {
-            // Draw asteroids
+            // Draw asteroids, one instanced multi-draw per level of detail
             asteroidShader.Bind();
             asteroidShader.SetUniformMatrix4f("u_Projection", projection);
             asteroidShader.SetUniformMatrix4f("u_View", view);
-            renderer.DrawInstanced(asteroid, asteroidShader, amount);
+            instanceMatrices.BindBase(ASTEROID_MATRIX_BINDING);
+            instanceIndices.BindBase(ASTEROID_INDEX_BINDING);
+            for (unsigned int lod = 0; lod < asteroid.GetLodCount(); lod++) {
+                unsigned int instances = lodOffsets[lod + 1] - lodOffsets[lod];
+                if (instances > 0) {
+                    renderer.DrawInstancedIndirect(asteroid, asteroidShader, instances, lod, lodOffsets[lod]);
+                }
+            }
         }
 
         window.SwapBuffers();
@@ -1284,11 +1440,15 @@ int testBlinnPhongLight(Window& window) {
     floorTex.Bind(0);
     simpleSpecTex.Bind(1);
 
-    Shader floorShader("data/shaders/phong.vert", "data/shaders/phong.frag");
-    floorShader.Bind();
-    floorShader.SetUniform1i("u_Material.diffuse", 0);
-    floorShader.SetUniform1i("u_Material.specular", 1);
-    floorShader.SetUniform1f("u_Material.shininess", 1.0f);
+    // Blinn-Phong is a compile-time variant, both variants have a single point light
+    ShaderVariants floorVariants("data/shaders/phong.vert", "data/shaders/phong.frag", PHONG_VARIANT_OPTIONS);
+    for (unsigned int blinn = 0; blinn < 2; blinn++) {
+        Shader& floorShader = floorVariants.Get(floorVariants.MakeKey({blinn, 0, 1, 0}));
+        floorShader.Bind();
+        floorShader.SetUniform1i("u_Material.diffuse", 0);
+        floorShader.SetUniform1i("u_Material.specular", 1);
+        floorShader.SetUniform1f("u_Material.shininess", 1.0f);
+    }
 
     PointLight pointLights[] = {
         {
@@ -1298,7 +1458,10 @@ int testBlinnPhongLight(Window& window) {
         },
     };
 
-    Lighting::SetPointLights(floorShader, "u_NumPtLights", 1, "u_PtLights", pointLights);
+    LightBuffer lights;
+    lights.SetPointLights(1, pointLights);
+    lights.Upload();
+    lights.Bind();
 
     // Camera
     Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
@@ -1329,7 +1492,8 @@ int testBlinnPhongLight(Window& window) {
         glm::mat4 view = camera.ViewMatrix();
         glm::mat4 model = glm::mat4(1.0);
 
-        floorShader.SetUniform1i("u_EnableBlinn", (int)blinn);
+        Shader& floorShader = floorVariants.Get(floorVariants.MakeKey({(unsigned int)blinn, 0, 1, 0}));
+        floorShader.Bind();
         floorShader.SetUniform3f("u_ViewPos", camera.GetPosition());
         floorShader.SetUniformMatrix4f("u_Projection", projection);
         floorShader.SetUniformMatrix4f("u_View", view);
@@ -1762,6 +1926,10 @@ int testOmniShadowMapping(Window& window) {
 }
 
 int testNormalMapping(Window& window) {
+    // The driver compiles the shaders while the rest of the scene loads
+    Shader objShader("data/shaders/normal_mapping.vert", "data/shaders/normal_mapping.frag");
+    Shader lightShader("data/shaders/basic.vert", "data/shaders/light.frag");
+
     VertexData quadData = initQuad();
     VertexData cubeData = initCube();
 
@@ -1770,8 +1938,16 @@ int testNormalMapping(Window& window) {
     Texture brickNormal("data/textures/brickwall_normal.jpg",
                         TextureOptions{TextureWrap::ClampToEdge, TextureWrap::ClampToEdge});
 
-    Shader objShader("data/shaders/normal_mapping.vert", "data/shaders/normal_mapping.frag");
-    Shader lightShader("data/shaders/basic.vert", "data/shaders/light.frag");
+    Renderer renderer;
+    renderer.SetDepthTest(true);
+
+    // Keep presenting blank frames instead of stalling until all programs are finished
+    while (!ShaderCompiler::AllReady() && !window.ShouldClose()) {
+        renderer.Clear();
+        window.SwapBuffers();
+        window.PollEvents();
+    }
+    ShaderCompiler::WaitAll();
 
     // Activate textures (not changing per frame)
     brickDiffuse.Bind(0);
@@ -1791,9 +1967,6 @@ int testNormalMapping(Window& window) {
 
     glm::vec3 lightPos(0.5f, 1.5f, 0.3f);
 
-    Renderer renderer;
-    renderer.SetDepthTest(true);
-
     while (!window.ShouldClose()) {
         double currentTime = Time::GetTime();
         deltaTime = currentTime - lastTime;
@@ -1842,11 +2015,62 @@ int testNormalMapping(Window& window) {
     return 0;
 }
 
-int main() {
+/* cookTextures converts images to KTX2 files next to them, for a cube map the six faces are followed by the output:
+ *   learnopengl cook [--srgb] [--no-flip] [--no-mips] [--bc | --bc-normal] [--min-psnr dB] image...
+ *   learnopengl cook [--srgb] [--no-mips] [--bc] --cube right left top bottom front back output.ktx2 */
+int cookTextures(const std::vector<std::string>& args) {
+    CookOptions options;
+    bool cube = false;
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < args.size(); i++) {
+        const std::string& arg = args[i];
+        if (arg == "--srgb") {
+            options.Srgb = true;
+        } else if (arg == "--no-flip") {
+            options.Flip = false;
+        } else if (arg == "--no-mips") {
+            options.GenerateMipMap = false;
+        } else if (arg == "--bc") {
+            options.Compression = CookCompression::Color;
+        } else if (arg == "--bc-normal") {
+            options.Compression = CookCompression::NormalMap;
+        } else if (arg == "--min-psnr" && i + 1 < args.size()) {
+            options.MinPSNR = std::stod(args[++i]);
+        } else if (arg == "--cube") {
+            cube = true;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+
+    if (cube) {
+        if (paths.size() != 7) {
+            spdlog::error("Cooking a cube map needs six faces and an output path");
+            return -1;
+        }
+        return TextureCooker::CookCubeMap(paths.data(), paths[6], options) ? 0 : -1;
+    }
+
+    int result = 0;
+    for (const std::string& path : paths) {
+        if (!TextureCooker::Cook(path, TextureCooker::GetCookedPath(path), options)) {
+            result = -1;
+        }
+    }
+
+    return result;
+}
+
+int main(int argc, char* argv[]) {
 #ifdef DEBUG
     spdlog::set_level(spdlog::level::debug);
 #endif
 
+    // Offline tools run without a window
+    if (argc > 1 && std::string(argv[1]) == "cook") {
+        return cookTextures(std::vector<std::string>(argv + 2, argv + argc));
+    }
+
     const unsigned int SCREEN_WIDTH = 800;
     const unsigned int SCREEN_HEIGHT = 600;
 
@@ -1854,5 +2078,10 @@ int main() {
     window.SetVSync(true);
     window.SetInputSystem(true);
 
-    return testNormalMapping(window);
+    int result = testNormalMapping(window);
+    // Compare against a run with an empty cache directory to see the cold vs warm startup difference
+    ProgramCache::LogStats();
+    TextureLoader::Shutdown();
+
+    return result;
 }
\ No newline at end of file
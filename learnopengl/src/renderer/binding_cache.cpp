@@ -0,0 +1,160 @@
+#include <renderer/binding_cache.h>
+
+#include <algorithm>
+
+BindingCacheInst BindingCache::s_Instance;
+
+/* update stores the id into the cached slot and returns true if the binding actually changed */
+bool BindingCache::update(unsigned int& cached, unsigned int id) {
+    if (cached == id) {
+        s_Instance.m_Stats.Hits++;
+        return false;
+    }
+
+    cached = id;
+    s_Instance.m_Stats.Misses++;
+    return true;
+}
+
+unsigned int& BindingCache::cachedBuffer(std::unordered_map<unsigned int, unsigned int>& buffers, unsigned int key) {
+    return buffers.try_emplace(key, s_Instance.m_DefaultBuffer).first->second;
+}
+
+void BindingCache::activateTextureUnit(unsigned int slot) {
+    if (update(s_Instance.m_ActiveTextureUnit, slot)) {
+        glActiveTexture(GL_TEXTURE0 + slot);
+    }
+}
+
+void BindingCache::BindProgram(unsigned int id) {
+    if (update(s_Instance.m_Program, id)) {
+        glUseProgram(id);
+    }
+}
+
+void BindingCache::BindVertexArray(unsigned int id) {
+    if (update(s_Instance.m_VertexArray, id)) {
+        glBindVertexArray(id);
+    }
+}
+
+void BindingCache::BindBuffer(unsigned int target, unsigned int id) {
+    // Element array buffer binding is stored in the currently bound VAO
+    unsigned int& cached = target == GL_ELEMENT_ARRAY_BUFFER
+                               ? cachedBuffer(s_Instance.m_ElementBuffers, s_Instance.m_VertexArray)
+                               : cachedBuffer(s_Instance.m_Buffers, target);
+    if (update(cached, id)) {
+        glBindBuffer(target, id);
+    }
+}
+
+void BindingCache::TrackBuffer(unsigned int target, unsigned int id) {
+    cachedBuffer(s_Instance.m_Buffers, target) = id;
+}
+
+void BindingCache::BindTexture(unsigned int target, unsigned int id) {
+    unsigned int unit = s_Instance.m_ActiveTextureUnit;
+    if (unit >= MAX_CACHED_TEXTURE_UNITS || (target != GL_TEXTURE_2D && target != GL_TEXTURE_CUBE_MAP)) {
+        s_Instance.m_Stats.Misses++;
+        glBindTexture(target, id);
+        return;
+    }
+
+    unsigned int& cached =
+        target == GL_TEXTURE_2D ? s_Instance.m_Texture2D[unit] : s_Instance.m_TextureCubeMap[unit];
+    if (update(cached, id)) {
+        glBindTexture(target, id);
+    }
+}
+
+void BindingCache::BindTextureUnit(unsigned int slot, unsigned int target, unsigned int id) {
+    activateTextureUnit(slot);
+    BindTexture(target, id);
+}
+
+void BindingCache::BindFrameBuffer(unsigned int target, unsigned int id) {
+    bool changed = false;
+    if (target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER) {
+        changed |= update(s_Instance.m_DrawFrameBuffer, id);
+    }
+    if (target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER) {
+        changed |= update(s_Instance.m_ReadFrameBuffer, id);
+    }
+
+    if (changed) {
+        glBindFramebuffer(target, id);
+    }
+}
+
+void BindingCache::BindRenderBuffer(unsigned int id) {
+    if (update(s_Instance.m_RenderBuffer, id)) {
+        glBindRenderbuffer(GL_RENDERBUFFER, id);
+    }
+}
+
+void BindingCache::DeleteProgram(unsigned int id) {
+    if (s_Instance.m_Program == id) {
+        s_Instance.m_Program = 0;
+    }
+}
+
+void BindingCache::DeleteVertexArray(unsigned int id) {
+    if (s_Instance.m_VertexArray == id) {
+        s_Instance.m_VertexArray = 0;
+    }
+    s_Instance.m_ElementBuffers.erase(id);
+}
+
+void BindingCache::DeleteBuffer(unsigned int id) {
+    for (auto& [target, buffer] : s_Instance.m_Buffers) {
+        if (buffer == id) {
+            buffer = 0;
+        }
+    }
+    // Only the bound VAO drops the deleted buffer, the others keep referencing it
+    for (auto& [vao, buffer] : s_Instance.m_ElementBuffers) {
+        if (buffer == id) {
+            buffer = vao == s_Instance.m_VertexArray ? 0 : UNKNOWN_BINDING;
+        }
+    }
+}
+
+void BindingCache::DeleteTexture(unsigned int id) {
+    for (unsigned int i = 0; i < MAX_CACHED_TEXTURE_UNITS; i++) {
+        if (s_Instance.m_Texture2D[i] == id) {
+            s_Instance.m_Texture2D[i] = 0;
+        }
+        if (s_Instance.m_TextureCubeMap[i] == id) {
+            s_Instance.m_TextureCubeMap[i] = 0;
+        }
+    }
+}
+
+void BindingCache::DeleteFrameBuffer(unsigned int id) {
+    if (s_Instance.m_DrawFrameBuffer == id) {
+        s_Instance.m_DrawFrameBuffer = 0;
+    }
+    if (s_Instance.m_ReadFrameBuffer == id) {
+        s_Instance.m_ReadFrameBuffer = 0;
+    }
+}
+
+void BindingCache::DeleteRenderBuffer(unsigned int id) {
+    if (s_Instance.m_RenderBuffer == id) {
+        s_Instance.m_RenderBuffer = 0;
+    }
+}
+
+void BindingCache::Invalidate() {
+    s_Instance.m_Program = UNKNOWN_BINDING;
+    s_Instance.m_VertexArray = UNKNOWN_BINDING;
+    s_Instance.m_DrawFrameBuffer = UNKNOWN_BINDING;
+    s_Instance.m_ReadFrameBuffer = UNKNOWN_BINDING;
+    s_Instance.m_RenderBuffer = UNKNOWN_BINDING;
+    s_Instance.m_ActiveTextureUnit = UNKNOWN_BINDING;
+    std::fill(s_Instance.m_Texture2D, s_Instance.m_Texture2D + MAX_CACHED_TEXTURE_UNITS, UNKNOWN_BINDING);
+    std::fill(s_Instance.m_TextureCubeMap, s_Instance.m_TextureCubeMap + MAX_CACHED_TEXTURE_UNITS, UNKNOWN_BINDING);
+    s_Instance.m_Buffers.clear();
+    s_Instance.m_ElementBuffers.clear();
+    s_Instance.m_DefaultBuffer = UNKNOWN_BINDING;
+}
@@ -0,0 +1,382 @@
+#include <renderer/block_compression.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+unsigned int GetBlockBytes(const BlockFormat format) {
+    switch (format) {
+        case BlockFormat::BC1:
+            return 8;
+        case BlockFormat::BC3:
+        case BlockFormat::BC5:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+uint16_t packRGB565(const float r, const float g, const float b) {
+    unsigned int r5 = (unsigned int)std::clamp(std::lround(r * 31.0f / 255.0f), 0L, 31L);
+    unsigned int g6 = (unsigned int)std::clamp(std::lround(g * 63.0f / 255.0f), 0L, 63L);
+    unsigned int b5 = (unsigned int)std::clamp(std::lround(b * 31.0f / 255.0f), 0L, 31L);
+    return (uint16_t)((r5 << 11) | (g6 << 5) | b5);
+}
+
+void unpackRGB565(const uint16_t color, int* rgb) {
+    int r5 = (color >> 11) & 31, g6 = (color >> 5) & 63, b5 = color & 31;
+    // Replicate the high bits so that the endpoints span the full [0, 255] range
+    rgb[0] = (r5 << 3) | (r5 >> 2);
+    rgb[1] = (g6 << 2) | (g6 >> 4);
+    rgb[2] = (b5 << 3) | (b5 >> 2);
+}
+
+/* bc1Palette builds the four colours of a block, c0 <= c1 selects the three colour mode with transparent black */
+void bc1Palette(const uint16_t c0, const uint16_t c1, int palette[4][4]) {
+    unpackRGB565(c0, palette[0]);
+    unpackRGB565(c1, palette[1]);
+    palette[0][3] = palette[1][3] = 255;
+
+    for (int c = 0; c < 3; c++) {
+        if (c0 > c1) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        } else {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    palette[2][3] = 255;
+    palette[3][3] = c0 > c1 ? 255 : 0;
+}
+
+/* bc1Indices picks the closest palette entry for every texel and returns the squared error of the block */
+int bc1Indices(const unsigned char* texels, const int palette[4][4], uint32_t& indices) {
+    indices = 0;
+    int error = 0;
+    for (int i = 0; i < 16; i++) {
+        int best = 0, bestDist = std::numeric_limits<int>::max();
+        for (int p = 0; p < 4; p++) {
+            int dr = texels[i * 4 + 0] - palette[p][0];
+            int dg = texels[i * 4 + 1] - palette[p][1];
+            int db = texels[i * 4 + 2] - palette[p][2];
+            int dist = dr * dr + dg * dg + db * db;
+            if (dist < bestDist) {
+                bestDist = dist;
+                best = p;
+            }
+        }
+        indices |= (uint32_t)best << (2 * i);
+        error += bestDist;
+    }
+
+    return error;
+}
+
+/* writeBC1 quantizes the endpoints and encodes the block in four colour mode, returning its squared error */
+int writeBC1(const unsigned char* texels, const float* end0, const float* end1, unsigned char* block) {
+    uint16_t c0 = packRGB565(end0[0], end0[1], end0[2]);
+    uint16_t c1 = packRGB565(end1[0], end1[1], end1[2]);
+    if (c0 < c1) {
+        std::swap(c0, c1);
+    }
+
+    uint32_t indices = 0;
+    int error = 0;
+    if (c0 == c1) {
+        // Both endpoints quantized to the same colour, every texel uses c0
+        int palette[4][4];
+        bc1Palette(c0, c1, palette);
+        for (int i = 0; i < 16; i++) {
+            for (int c = 0; c < 3; c++) {
+                int d = texels[i * 4 + c] - palette[0][c];
+                error += d * d;
+            }
+        }
+    } else {
+        int palette[4][4];
+        bc1Palette(c0, c1, palette);
+        error = bc1Indices(texels, palette, indices);
+    }
+
+    std::memcpy(block, &c0, 2);
+    std::memcpy(block + 2, &c1, 2);
+    std::memcpy(block + 4, &indices, 4);
+    return error;
+}
+
+/* encodeBC1 fits the endpoints along the principal axis of the block colours, then refines them with a least
+ * squares fit to the chosen indices */
+void encodeBC1(const unsigned char* texels, unsigned char* block) {
+    float mean[3] = {0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) {
+            mean[c] += texels[i * 4 + c] / 16.0f;
+        }
+    }
+
+    float cov[6] = {};
+    for (int i = 0; i < 16; i++) {
+        float r = texels[i * 4 + 0] - mean[0], g = texels[i * 4 + 1] - mean[1], b = texels[i * 4 + 2] - mean[2];
+        cov[0] += r * r;
+        cov[1] += r * g;
+        cov[2] += r * b;
+        cov[3] += g * g;
+        cov[4] += g * b;
+        cov[5] += b * b;
+    }
+
+    // Power iteration for the dominant eigenvector of the covariance
+    float axis[3] = {1.0f, 1.0f, 1.0f};
+    for (int iter = 0; iter < 8; iter++) {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float length = std::max({std::fabs(x), std::fabs(y), std::fabs(z)});
+        if (length < 1e-6f) {
+            break;
+        }
+        axis[0] = x / length;
+        axis[1] = y / length;
+        axis[2] = z / length;
+    }
+
+    float minT = std::numeric_limits<float>::max(), maxT = -std::numeric_limits<float>::max();
+    float axisLength2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    for (int i = 0; i < 16; i++) {
+        float t = 0.0f;
+        for (int c = 0; c < 3; c++) {
+            t += (texels[i * 4 + c] - mean[c]) * axis[c];
+        }
+        t /= axisLength2;
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+
+    // Inset the endpoints slightly, the extremes are usually better served by the interpolated colours
+    float inset = (maxT - minT) / 16.0f;
+    float end0[3], end1[3];
+    for (int c = 0; c < 3; c++) {
+        end0[c] = mean[c] + axis[c] * (maxT - inset);
+        end1[c] = mean[c] + axis[c] * (minT + inset);
+    }
+
+    unsigned char best[8];
+    int bestError = writeBC1(texels, end0, end1, best);
+
+    for (int iter = 0; iter < 2 && bestError > 0; iter++) {
+        uint16_t c0, c1;
+        uint32_t indices;
+        std::memcpy(&c0, best, 2);
+        std::memcpy(&c1, best + 2, 2);
+        std::memcpy(&indices, best + 4, 4);
+        if (c0 == c1) {
+            break;
+        }
+
+        // Solve for the endpoints that minimise the error given each texel's weight towards c0
+        const float weights[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+        float aa = 0.0f, bb = 0.0f, ab = 0.0f, ax[3] = {}, bx[3] = {};
+        for (int i = 0; i < 16; i++) {
+            float w = weights[(indices >> (2 * i)) & 3];
+            aa += w * w;
+            bb += (1.0f - w) * (1.0f - w);
+            ab += w * (1.0f - w);
+            for (int c = 0; c < 3; c++) {
+                ax[c] += w * texels[i * 4 + c];
+                bx[c] += (1.0f - w) * texels[i * 4 + c];
+            }
+        }
+
+        float det = aa * bb - ab * ab;
+        if (std::fabs(det) < 1e-6f) {
+            break;
+        }
+        for (int c = 0; c < 3; c++) {
+            end0[c] = (ax[c] * bb - bx[c] * ab) / det;
+            end1[c] = (bx[c] * aa - ax[c] * ab) / det;
+        }
+
+        unsigned char candidate[8];
+        int error = writeBC1(texels, end0, end1, candidate);
+        if (error >= bestError) {
+            break;
+        }
+        bestError = error;
+        std::memcpy(best, candidate, 8);
+    }
+
+    std::memcpy(block, best, 8);
+}
+
+void decodeBC1(const unsigned char* block, unsigned char* texels) {
+    uint16_t c0, c1;
+    uint32_t indices;
+    std::memcpy(&c0, block, 2);
+    std::memcpy(&c1, block + 2, 2);
+    std::memcpy(&indices, block + 4, 4);
+
+    int palette[4][4];
+    bc1Palette(c0, c1, palette);
+    for (int i = 0; i < 16; i++) {
+        const int* color = palette[(indices >> (2 * i)) & 3];
+        for (int c = 0; c < 4; c++) {
+            texels[i * 4 + c] = (unsigned char)color[c];
+        }
+    }
+}
+
+/* encodeBC4 stores one channel with the min and max values as endpoints and six interpolated steps between them */
+void encodeBC4(const unsigned char* texels, const int channel, unsigned char* block) {
+    int minV = 255, maxV = 0;
+    for (int i = 0; i < 16; i++) {
+        minV = std::min(minV, (int)texels[i * 4 + channel]);
+        maxV = std::max(maxV, (int)texels[i * 4 + channel]);
+    }
+
+    block[0] = (unsigned char)maxV;
+    block[1] = (unsigned char)minV;
+
+    uint64_t indices = 0;
+    if (maxV > minV) {
+        // Palette index 0 is max, 1 is min, 2..7 step from max towards min
+        const int order[8] = {1, 7, 6, 5, 4, 3, 2, 0};
+        int range = maxV - minV;
+        for (int i = 0; i < 16; i++) {
+            int step = ((texels[i * 4 + channel] - minV) * 14 + range) / (2 * range);
+            indices |= (uint64_t)order[step] << (3 * i);
+        }
+    }
+
+    for (int i = 0; i < 6; i++) {
+        block[2 + i] = (unsigned char)(indices >> (8 * i));
+    }
+}
+
+void decodeBC4(const unsigned char* block, const int channel, unsigned char* texels) {
+    int r0 = block[0], r1 = block[1];
+    int palette[8] = {r0, r1};
+    if (r0 > r1) {
+        for (int i = 1; i < 7; i++) {
+            palette[i + 1] = ((7 - i) * r0 + i * r1) / 7;
+        }
+    } else {
+        for (int i = 1; i < 5; i++) {
+            palette[i + 1] = ((5 - i) * r0 + i * r1) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; i++) {
+        indices |= (uint64_t)block[2 + i] << (8 * i);
+    }
+    for (int i = 0; i < 16; i++) {
+        texels[i * 4 + channel] = (unsigned char)palette[(indices >> (3 * i)) & 7];
+    }
+}
+
+void EncodeBlock(const BlockFormat format, const unsigned char* texels, unsigned char* block) {
+    switch (format) {
+        case BlockFormat::BC1:
+            encodeBC1(texels, block);
+            break;
+        case BlockFormat::BC3:
+            encodeBC4(texels, 3, block);
+            encodeBC1(texels, block + 8);
+            break;
+        case BlockFormat::BC5:
+            encodeBC4(texels, 0, block);
+            encodeBC4(texels, 1, block + 8);
+            break;
+        default:
+            break;
+    }
+}
+
+void DecodeBlock(const BlockFormat format, const unsigned char* block, unsigned char* texels) {
+    switch (format) {
+        case BlockFormat::BC1:
+            decodeBC1(block, texels);
+            break;
+        case BlockFormat::BC3:
+            decodeBC1(block + 8, texels);
+            decodeBC4(block, 3, texels);
+            break;
+        case BlockFormat::BC5:
+            for (int i = 0; i < 16; i++) {
+                texels[i * 4 + 2] = 0;
+                texels[i * 4 + 3] = 255;
+            }
+            decodeBC4(block, 0, texels);
+            decodeBC4(block + 8, 1, texels);
+            break;
+        default:
+            break;
+    }
+}
+
+std::vector<unsigned char> CompressImage(const BlockFormat format, const unsigned char* rgba, const int width,
+                                         const int height) {
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    unsigned int blockBytes = GetBlockBytes(format);
+    std::vector<unsigned char> blocks((size_t)blocksX * blocksY * blockBytes);
+
+    unsigned char texels[16 * 4];
+    for (int by = 0; by < blocksY; by++) {
+        for (int bx = 0; bx < blocksX; bx++) {
+            for (int y = 0; y < 4; y++) {
+                int sy = std::min(by * 4 + y, height - 1);
+                for (int x = 0; x < 4; x++) {
+                    int sx = std::min(bx * 4 + x, width - 1);
+                    std::memcpy(&texels[(y * 4 + x) * 4], &rgba[((size_t)sy * width + sx) * 4], 4);
+                }
+            }
+            EncodeBlock(format, texels, &blocks[((size_t)by * blocksX + bx) * blockBytes]);
+        }
+    }
+
+    return blocks;
+}
+
+std::vector<unsigned char> DecompressImage(const BlockFormat format, const unsigned char* blocks, const int width,
+                                           const int height) {
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    unsigned int blockBytes = GetBlockBytes(format);
+    std::vector<unsigned char> rgba((size_t)width * height * 4);
+
+    unsigned char texels[16 * 4];
+    for (int by = 0; by < blocksY; by++) {
+        for (int bx = 0; bx < blocksX; bx++) {
+            DecodeBlock(format, &blocks[((size_t)by * blocksX + bx) * blockBytes], texels);
+            for (int y = 0; y < 4 && by * 4 + y < height; y++) {
+                for (int x = 0; x < 4 && bx * 4 + x < width; x++) {
+                    std::memcpy(&rgba[((size_t)(by * 4 + y) * width + bx * 4 + x) * 4], &texels[(y * 4 + x) * 4], 4);
+                }
+            }
+        }
+    }
+
+    return rgba;
+}
+
+double ComputePSNR(const unsigned char* a, const unsigned char* b, const size_t texelCount,
+                   const unsigned int channels) {
+    double sum = 0.0;
+    for (size_t i = 0; i < texelCount; i++) {
+        for (unsigned int c = 0; c < channels; c++) {
+            double d = (double)a[i * 4 + c] - (double)b[i * 4 + c];
+            sum += d * d;
+        }
+    }
+
+    if (sum == 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    double mse = sum / (double)(texelCount * channels);
+    return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
@@ -1,4 +1,5 @@
 #include <common.h>
+#include <renderer/binding_cache.h>
 #include <renderer/fbo.h>
 
 FrameBuffer::FrameBuffer() : m_ReferenceID(0) {
@@ -8,15 +9,16 @@ FrameBuffer::FrameBuffer() : m_ReferenceID(0) {
 
 FrameBuffer::~FrameBuffer() {
     spdlog::debug("FrameBuffer {} destroyed", m_ReferenceID);
+    BindingCache::DeleteFrameBuffer(m_ReferenceID);
     glDeleteFramebuffers(1, &m_ReferenceID);
 }
 
 void FrameBuffer::Bind() const {
-    glBindFramebuffer(GL_FRAMEBUFFER, m_ReferenceID);
+    BindingCache::BindFrameBuffer(GL_FRAMEBUFFER, m_ReferenceID);
 }
 
 void FrameBuffer::Unbind() const {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    BindingCache::BindFrameBuffer(GL_FRAMEBUFFER, 0);
 }
 
 void FrameBuffer::AddColorAttachment(const Texture& tex, const unsigned int slot, const int level) const {
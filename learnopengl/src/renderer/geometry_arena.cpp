@@ -0,0 +1,149 @@
+#include <common.h>
+#include <renderer/geometry_arena.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+RangeAllocator::RangeAllocator(unsigned int capacity) : m_Capacity(capacity), m_Used(0) {
+    if (capacity > 0) {
+        m_FreeRanges[0] = capacity;
+    }
+}
+
+bool RangeAllocator::Allocate(unsigned int size, unsigned int& offset) {
+    if (size == 0) {
+        offset = 0;
+        return true;
+    }
+
+    for (std::map<unsigned int, unsigned int>::iterator it = m_FreeRanges.begin(); it != m_FreeRanges.end(); ++it) {
+        if (it->second < size) {
+            continue;
+        }
+
+        offset = it->first;
+        unsigned int remaining = it->second - size;
+        m_FreeRanges.erase(it);
+        if (remaining > 0) {
+            m_FreeRanges[offset + size] = remaining;
+        }
+
+        m_Used += size;
+        return true;
+    }
+
+    return false;
+}
+
+void RangeAllocator::Free(unsigned int offset, unsigned int size) {
+    if (size == 0) {
+        return;
+    }
+
+    m_Used -= size;
+    std::map<unsigned int, unsigned int>::iterator it = m_FreeRanges.emplace(offset, size).first;
+
+    // Merge with the following free range
+    std::map<unsigned int, unsigned int>::iterator next = std::next(it);
+    if (next != m_FreeRanges.end() && it->first + it->second == next->first) {
+        it->second += next->second;
+        m_FreeRanges.erase(next);
+    }
+
+    // Merge with the preceding free range
+    if (it != m_FreeRanges.begin()) {
+        std::map<unsigned int, unsigned int>::iterator prev = std::prev(it);
+        if (prev->first + prev->second == it->first) {
+            prev->second += it->second;
+            m_FreeRanges.erase(it);
+        }
+    }
+}
+
+GeometryArena::GeometryArena(const VertexBufferLayout& layout, unsigned int pageVertices, unsigned int pageIndices)
+    : m_Layout(layout), m_PageVertices(pageVertices), m_PageIndices(pageIndices) {}
+
+/* Allocate finds a page of the narrowest index type with room for both the vertices and the indices, creating a new one
+ * if none has, and uploads the data into the allocated ranges. Indices are relative to the range, so the type only
+ * depends on the largest index and not on where the range lands in the page. */
+GeometryRange GeometryArena::Allocate(const void* vertices, unsigned int vertexCount, const unsigned int* indices,
+                                      unsigned int indexCount) {
+    GeometryRange range;
+    range.VertexCount = vertexCount;
+    range.IndexCount = indexCount;
+
+    unsigned int indexType = IndexBuffer::SelectType(indices, indexCount);
+    unsigned int baseVertex = 0;
+    for (const std::unique_ptr<GeometryPage>& page : m_Pages) {
+        if (page->IBO->GetType() != indexType) {
+            continue;
+        }
+        if (!page->Vertices.Allocate(vertexCount, baseVertex)) {
+            continue;
+        }
+        if (!page->Indices.Allocate(indexCount, range.FirstIndex)) {
+            page->Vertices.Free(baseVertex, vertexCount);
+            continue;
+        }
+
+        range.Page = page.get();
+        break;
+    }
+
+    if (!range.Page) {
+        GeometryPage& page = createPage(vertexCount, indexCount, indexType);
+        if (!page.Vertices.Allocate(vertexCount, baseVertex) || !page.Indices.Allocate(indexCount, range.FirstIndex)) {
+            throw std::runtime_error("Failed to allocate geometry");
+        }
+        range.Page = &page;
+    }
+
+    range.BaseVertex = (int)baseVertex;
+    unsigned int stride = m_Layout.GetStride();
+    range.Page->VBO->InsertData(baseVertex * stride, vertices, vertexCount * stride);
+    range.Page->IBO->InsertData(range.FirstIndex, indices, indexCount);
+
+    return range;
+}
+
+/* Free returns the range to its page, pages that become empty are released */
+void GeometryArena::Free(const GeometryRange& range) {
+    if (!range.Page) {
+        return;
+    }
+
+    range.Page->Vertices.Free((unsigned int)range.BaseVertex, range.VertexCount);
+    range.Page->Indices.Free(range.FirstIndex, range.IndexCount);
+
+    if (range.Page->Vertices.GetUsed() == 0 && range.Page->Indices.GetUsed() == 0) {
+        m_Pages.erase(std::find_if(m_Pages.begin(), m_Pages.end(), [&range](const std::unique_ptr<GeometryPage>& p) {
+            return p.get() == range.Page;
+        }));
+    }
+}
+
+/* CreateVertexArray creates a new VAO over the page buffers, used when geometry needs additional private attributes
+ * such as per-instance data */
+std::shared_ptr<VertexArray> GeometryArena::CreateVertexArray(const GeometryPage& page) const {
+    std::shared_ptr<VertexArray> vao = std::make_shared<VertexArray>();
+    vao->AddBuffer(*page.VBO, m_Layout);
+    page.IBO->Bind();
+
+    return vao;
+}
+
+GeometryPage& GeometryArena::createPage(unsigned int vertexCount, unsigned int indexCount, unsigned int indexType) {
+    unsigned int pageVertices = std::max(vertexCount, m_PageVertices);
+    unsigned int pageIndices = std::max(indexCount, m_PageIndices);
+
+    std::unique_ptr<GeometryPage> page(
+        new GeometryPage{nullptr, nullptr, nullptr, RangeAllocator(pageVertices), RangeAllocator(pageIndices)});
+    page->VBO = std::make_shared<VertexBuffer>(pageVertices * m_Layout.GetStride());
+    page->IBO = std::make_shared<IndexBuffer>(pageIndices, indexType);
+    page->VAO = CreateVertexArray(*page);
+
+    spdlog::debug("GeometryArena page created ({} vertices, {} {}-bit indices)", pageVertices, pageIndices,
+                  IndexBuffer::GetSizeOfType(indexType) * 8);
+    m_Pages.push_back(std::move(page));
+    return *m_Pages.back();
+}
@@ -1,21 +1,87 @@
 #include <common.h>
+#include <renderer/binding_cache.h>
 #include <renderer/ibo.h>
 
-IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count) : m_ReferenceID(0), m_Count(count) {
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/* narrowIndices converts indices to the stored type into narrowed, 32-bit indices are returned as they are */
+static const void* narrowIndices(const unsigned int* data, unsigned int count, unsigned int type,
+                                 std::vector<unsigned char>& narrowed) {
+    if (type == GL_UNSIGNED_INT || !data) {
+        return data;
+    }
+
+    narrowed.resize(count * IndexBuffer::GetSizeOfType(type));
+    if (type == GL_UNSIGNED_SHORT) {
+        std::transform(data, data + count, (uint16_t*)narrowed.data(), [](unsigned int i) { return (uint16_t)i; });
+    } else {
+        std::transform(data, data + count, (uint8_t*)narrowed.data(), [](unsigned int i) { return (uint8_t)i; });
+    }
+
+    return narrowed.data();
+}
+
+IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count)
+    : m_ReferenceID(0), m_Count(count), m_Type(SelectType(data, count)) {
+    std::vector<unsigned char> narrowed;
+    glGenBuffers(1, &m_ReferenceID);
+    Bind();
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_Count * GetIndexSize(), narrowIndices(data, count, m_Type, narrowed),
+                 GL_STATIC_DRAW);
+}
+
+/* IndexBuffer allocates immutable storage for count indices that can only be filled through InsertData */
+IndexBuffer::IndexBuffer(unsigned int count, unsigned int type) : m_ReferenceID(0), m_Count(count), m_Type(type) {
     glGenBuffers(1, &m_ReferenceID);
     Bind();
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_Count * sizeof(GLuint), data, GL_STATIC_DRAW);
+    glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, m_Count * GetIndexSize(), nullptr, GL_DYNAMIC_STORAGE_BIT);
 }
 
 IndexBuffer::~IndexBuffer() {
     spdlog::debug("IndexBuffer {} destroyed", m_ReferenceID);
+    BindingCache::DeleteBuffer(m_ReferenceID);
     glDeleteBuffers(1, &m_ReferenceID);
 }
 
 void IndexBuffer::Bind() const {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ReferenceID);
+    BindingCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ReferenceID);
 }
 
 void IndexBuffer::Unbind() const {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-}
\ No newline at end of file
+    BindingCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void IndexBuffer::InsertData(unsigned int offset, const unsigned int* data, unsigned int count) const {
+    std::vector<unsigned char> narrowed;
+    glNamedBufferSubData(m_ReferenceID, offset * GetIndexSize(), count * GetIndexSize(),
+                         narrowIndices(data, count, m_Type, narrowed));
+}
+
+/* SelectType stops at 16-bit indices, 8-bit indices are emulated with a conversion on several GPUs */
+unsigned int IndexBuffer::SelectType(const unsigned int* data, unsigned int count) {
+    // Without data the buffer is filled later with indices of unknown range
+    if (!data) {
+        return GL_UNSIGNED_INT;
+    }
+    if (count == 0) {
+        return GL_UNSIGNED_SHORT;
+    }
+
+    return *std::max_element(data, data + count) <= 0xffff ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+unsigned int IndexBuffer::GetSizeOfType(unsigned int type) {
+    switch (type) {
+        case GL_UNSIGNED_INT:
+            return 4;
+        case GL_UNSIGNED_SHORT:
+            return 2;
+        case GL_UNSIGNED_BYTE:
+            return 1;
+    }
+
+    assert(false);
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include <common.h>
+#include <renderer/binding_cache.h>
+#include <renderer/indirect.h>
+
+IndirectBuffer::IndirectBuffer(const std::vector<DrawElementsIndirectCommand>& commands)
+    : m_ReferenceID(0), m_Commands(commands) {
+    glGenBuffers(1, &m_ReferenceID);
+    Bind();
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, m_Commands.size() * sizeof(DrawElementsIndirectCommand), m_Commands.data(),
+                 GL_DYNAMIC_DRAW);
+}
+
+IndirectBuffer::~IndirectBuffer() {
+    spdlog::debug("IndirectBuffer {} destroyed", m_ReferenceID);
+    BindingCache::DeleteBuffer(m_ReferenceID);
+    glDeleteBuffers(1, &m_ReferenceID);
+}
+
+void IndirectBuffer::Bind() const {
+    BindingCache::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_ReferenceID);
+}
+
+void IndirectBuffer::Unbind() const {
+    BindingCache::BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+/* SetInstanceCount updates the instance range of every command, only re-uploading when it actually changes. Instanced
+ * attributes are read starting at baseInstance. */
+void IndirectBuffer::SetInstanceCount(const unsigned int instances, const unsigned int baseInstance) {
+    if (m_Commands.empty() ||
+        (m_Commands[0].InstanceCount == instances && m_Commands[0].BaseInstance == baseInstance)) {
+        return;
+    }
+
+    for (DrawElementsIndirectCommand& cmd : m_Commands) {
+        cmd.InstanceCount = instances;
+        cmd.BaseInstance = baseInstance;
+    }
+
+    Bind();
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, m_Commands.size() * sizeof(DrawElementsIndirectCommand),
+                    m_Commands.data());
+}
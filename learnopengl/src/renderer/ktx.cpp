@@ -0,0 +1,184 @@
+#include <renderer/ktx.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+
+const unsigned char KTX2_IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+const size_t KTX2_HEADER_SIZE = 80;
+const size_t KTX2_LEVEL_INDEX_SIZE = 24;
+
+struct KtxHeader {
+    unsigned char Identifier[12];
+    uint32_t VkFormat;
+    uint32_t TypeSize;
+    uint32_t PixelWidth;
+    uint32_t PixelHeight;
+    uint32_t PixelDepth;
+    uint32_t LayerCount;
+    uint32_t FaceCount;
+    uint32_t LevelCount;
+    uint32_t SupercompressionScheme;
+    uint32_t DfdByteOffset;
+    uint32_t DfdByteLength;
+    uint32_t KvdByteOffset;
+    uint32_t KvdByteLength;
+    uint64_t SgdByteOffset;
+    uint64_t SgdByteLength;
+};
+static_assert(sizeof(KtxHeader) == KTX2_HEADER_SIZE, "KTX2 header must be 80 bytes");
+
+struct KtxLevelIndex {
+    uint64_t ByteOffset;
+    uint64_t ByteLength;
+    uint64_t UncompressedByteLength;
+};
+static_assert(sizeof(KtxLevelIndex) == KTX2_LEVEL_INDEX_SIZE, "KTX2 level index entry must be 24 bytes");
+
+const KtxFormatInfo KTX_FORMATS[] = {
+    {KtxFormat::RGBA8, GL_RGBA8, GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, 1, BlockFormat::None, false, nullptr},
+    {KtxFormat::RGBA8_SRGB, GL_SRGB8_ALPHA8, GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, 1, BlockFormat::None, true,
+     nullptr},
+    {KtxFormat::BC1_RGB, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, 0, 0, 8, 4,
+     BlockFormat::BC1, false, "GL_EXT_texture_compression_s3tc"},
+    {KtxFormat::BC1_RGB_SRGB, GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, 0, 0, 8, 4,
+     BlockFormat::BC1, true, "GL_EXT_texture_compression_s3tc"},
+    {KtxFormat::BC3, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 0, 0, 16, 4,
+     BlockFormat::BC3, false, "GL_EXT_texture_compression_s3tc"},
+    {KtxFormat::BC3_SRGB, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 0, 0, 16, 4,
+     BlockFormat::BC3, true, "GL_EXT_texture_compression_s3tc"},
+    // RGTC is core since OpenGL 3.0, two channel data is never sRGB
+    {KtxFormat::BC5, GL_COMPRESSED_RG_RGTC2, GL_COMPRESSED_RG_RGTC2, 0, 0, 16, 4, BlockFormat::BC5, false, nullptr},
+};
+
+const KtxFormatInfo* FindKtxFormat(unsigned int vkFormat) {
+    for (const KtxFormatInfo& format : KTX_FORMATS) {
+        if ((unsigned int)format.VkFormat == vkFormat) {
+            return &format;
+        }
+    }
+
+    return nullptr;
+}
+
+size_t KtxImageSize(const KtxFormatInfo& format, unsigned int width, unsigned int height) {
+    size_t blocksX = (width + format.BlockSize - 1) / format.BlockSize;
+    size_t blocksY = (height + format.BlockSize - 1) / format.BlockSize;
+    return blocksX * blocksY * format.BlockBytes;
+}
+
+KtxFile::KtxFile(const std::string& filePath)
+    : m_File(filePath), m_Format(nullptr), m_Width(0), m_Height(0), m_FaceCount(0) {
+    const unsigned char* data = m_File.GetData();
+    size_t size = m_File.GetSize();
+
+    KtxHeader header;
+    if (size < KTX2_HEADER_SIZE) {
+        spdlog::error("[Texture Error] KTX2 file '{}' failed to load", filePath);
+        throw "Cannot load KTX2 file";
+    }
+    std::memcpy(&header, data, KTX2_HEADER_SIZE);
+
+    m_Format = FindKtxFormat(header.VkFormat);
+    bool valid = std::memcmp(header.Identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0 && m_Format &&
+                 header.PixelWidth > 0 && header.PixelHeight > 0 && header.PixelDepth == 0 &&
+                 header.LayerCount == 0 && (header.FaceCount == 1 || header.FaceCount == 6) &&
+                 header.SupercompressionScheme == 0;
+    if (!valid) {
+        spdlog::error("[Texture Error] KTX2 file '{}' has an unsupported layout or format {}", filePath,
+                      header.VkFormat);
+        throw "Unsupported KTX2 file";
+    }
+
+    m_Width = header.PixelWidth;
+    m_Height = header.PixelHeight;
+    m_FaceCount = header.FaceCount;
+
+    // A level count of 0 asks the loader to generate the mips, the full resolution image is still stored
+    unsigned int levelCount = header.LevelCount > 0 ? header.LevelCount : 1;
+    if (KTX2_HEADER_SIZE + levelCount * KTX2_LEVEL_INDEX_SIZE > size) {
+        spdlog::error("[Texture Error] KTX2 file '{}' is truncated", filePath);
+        throw "Truncated KTX2 file";
+    }
+
+    for (unsigned int level = 0; level < levelCount; level++) {
+        KtxLevelIndex index;
+        std::memcpy(&index, data + KTX2_HEADER_SIZE + level * KTX2_LEVEL_INDEX_SIZE, KTX2_LEVEL_INDEX_SIZE);
+
+        unsigned int w = std::max(1u, m_Width >> level);
+        unsigned int h = std::max(1u, m_Height >> level);
+        size_t expected = KtxImageSize(*m_Format, w, h) * m_FaceCount;
+        // Written so that a malformed offset or length cannot wrap around
+        if (index.ByteLength > size || index.ByteOffset > size - index.ByteLength || index.ByteLength < expected) {
+            spdlog::error("[Texture Error] KTX2 file '{}' has an invalid level {}", filePath, level);
+            throw "Truncated KTX2 file";
+        }
+
+        m_Levels.push_back({data + index.ByteOffset, (size_t)index.ByteLength});
+    }
+}
+
+/* WriteKtx stores the levels smallest first, as the format recommends for streaming, with the level index pointing at
+ * each of them */
+bool WriteKtx(const std::string& filePath, const KtxImage& image) {
+    const KtxFormatInfo* format = FindKtxFormat((unsigned int)image.Format);
+    if (!format || image.Levels.empty()) {
+        return false;
+    }
+
+    unsigned int levelCount = (unsigned int)image.Levels.size();
+
+    // Orientation key/value pair, padded to 4 bytes
+    std::string key = "KTXorientation";
+    uint32_t kvLength = (uint32_t)(key.size() + 1 + image.Orientation.size() + 1);
+    std::vector<unsigned char> kvd(sizeof(uint32_t) + kvLength, 0);
+    std::memcpy(kvd.data(), &kvLength, sizeof(uint32_t));
+    std::memcpy(kvd.data() + sizeof(uint32_t), key.c_str(), key.size() + 1);
+    std::memcpy(kvd.data() + sizeof(uint32_t) + key.size() + 1, image.Orientation.c_str(),
+                image.Orientation.size() + 1);
+    kvd.resize((kvd.size() + 3) & ~(size_t)3, 0);
+
+    KtxHeader header = {};
+    std::memcpy(header.Identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+    header.VkFormat = (uint32_t)image.Format;
+    header.TypeSize = 1;
+    header.PixelWidth = image.Width;
+    header.PixelHeight = image.Height;
+    header.FaceCount = image.FaceCount;
+    header.LevelCount = levelCount;
+    header.KvdByteOffset = (uint32_t)(KTX2_HEADER_SIZE + levelCount * KTX2_LEVEL_INDEX_SIZE);
+    header.KvdByteLength = (uint32_t)kvd.size();
+
+    // Level data is aligned to both the texel block size and 4 bytes
+    size_t alignment = std::lcm((size_t)format->BlockBytes, (size_t)4);
+    std::vector<KtxLevelIndex> levelIndex(levelCount);
+    size_t offset = header.KvdByteOffset + kvd.size();
+    for (int level = (int)levelCount - 1; level >= 0; level--) {
+        offset = (offset + alignment - 1) / alignment * alignment;
+        levelIndex[level].ByteOffset = offset;
+        levelIndex[level].ByteLength = image.Levels[level].size();
+        levelIndex[level].UncompressedByteLength = image.Levels[level].size();
+        offset += image.Levels[level].size();
+    }
+
+    std::ofstream stream(filePath, std::ios::binary | std::ios::trunc);
+    if (!stream) {
+        spdlog::error("[Texture Error] Cannot write KTX2 file '{}'", filePath);
+        return false;
+    }
+
+    stream.write((const char*)&header, sizeof(header));
+    stream.write((const char*)levelIndex.data(), levelIndex.size() * sizeof(KtxLevelIndex));
+    stream.write((const char*)kvd.data(), kvd.size());
+
+    size_t written = header.KvdByteOffset + kvd.size();
+    const char padding[16] = {};
+    for (int level = (int)levelCount - 1; level >= 0; level--) {
+        stream.write(padding, levelIndex[level].ByteOffset - written);
+        stream.write((const char*)image.Levels[level].data(), image.Levels[level].size());
+        written = levelIndex[level].ByteOffset + image.Levels[level].size();
+    }
+
+    return (bool)stream;
+}
@@ -1,46 +1,96 @@
+#include <common.h>
 #include <renderer/light.h>
 
-void Lighting::SetDirectionalLight(Shader& shader, const std::string& name, const DirectionalLight& directLight) {
-    shader.SetUniform1i("u_EnableDirLight", 1);
-    shader.SetUniform3f(name + ".inner.ambient", directLight.Inner.Ambient());
-    shader.SetUniform3f(name + ".inner.diffuse", directLight.Inner.Diffuse());
-    shader.SetUniform3f(name + ".inner.specular", directLight.Inner.Specular());
-    shader.SetUniform3f(name + ".direction", directLight.Direction);
+#include <algorithm>
+#include <cstring>
+
+static PackedBasicLight packBasicLight(const BasicLight& light) {
+    return PackedBasicLight{light.Ambient(), 0.0f, light.Diffuse(), 0.0f, light.Specular(), 0.0f};
+}
+
+static PackedAttenuation packAttenuation(const Attenuation& atten) {
+    return PackedAttenuation{atten.Constant, atten.Linear, atten.Quadratic, 0.0f};
 }
 
-void Lighting::SetPointLights(Shader& shader, const std::string& numName, const unsigned int numLights,
-                              const std::string& name, const PointLight* ptLights) {
-    shader.SetUniform1i(numName, numLights);
+LightBuffer::LightBuffer() : m_UBO(sizeof(LightBlock)), m_Block(), m_DirtyBegin(0), m_DirtyEnd(sizeof(LightBlock)) {}
+
+void LightBuffer::SetDirectionalLight(const DirectionalLight& directLight) {
+    PackedDirectionalLight packed = {packBasicLight(directLight.Inner), directLight.Direction, 0.0f};
+    write(&m_Block.DirLight, &packed, sizeof(packed));
 
-    for (unsigned int i = 0; i < numLights; i++) {
-        std::string indexedName = name + "[" + std::to_string(i) + "]";
-        shader.SetUniform3f(indexedName + ".inner.ambient", ptLights[i].Inner.Ambient());
-        shader.SetUniform3f(indexedName + ".inner.diffuse", ptLights[i].Inner.Diffuse());
-        shader.SetUniform3f(indexedName + ".inner.specular", ptLights[i].Inner.Specular());
+    int enable = 1;
+    write(&m_Block.EnableDirLight, &enable, sizeof(enable));
+}
+
+void LightBuffer::DisableDirectionalLight() {
+    int enable = 0;
+    write(&m_Block.EnableDirLight, &enable, sizeof(enable));
+}
 
-        shader.SetUniform3f(indexedName + ".position", ptLights[i].Position);
-        shader.SetUniform1f(indexedName + ".atten.constant", ptLights[i].Atten.Constant);
-        shader.SetUniform1f(indexedName + ".atten.linear", ptLights[i].Atten.Linear);
-        shader.SetUniform1f(indexedName + ".atten.quadratic", ptLights[i].Atten.Quadratic);
+void LightBuffer::SetPointLight(const unsigned int index, const PointLight& ptLight) {
+    if (index >= MAX_POINT_LIGHTS) {
+        spdlog::error("[LightBuffer Error] Point light index {} out of range", index);
+        return;
     }
+
+    PackedPointLight packed = {packBasicLight(ptLight.Inner), ptLight.Position, 0.0f, packAttenuation(ptLight.Atten)};
+    write(&m_Block.PtLights[index], &packed, sizeof(packed));
 }
 
-void Lighting::SetSpotLights(Shader& shader, const std::string& numName, const unsigned int numLights,
-                             const std::string& name, const SpotLight* spLights) {
-    shader.SetUniform1i(numName, numLights);
+void LightBuffer::SetPointLights(const unsigned int numLights, const PointLight* ptLights) {
+    int count = (int)std::min(numLights, MAX_POINT_LIGHTS);
+    write(&m_Block.NumPtLights, &count, sizeof(count));
 
-    for (unsigned int i = 0; i < numLights; i++) {
-        std::string indexedName = name + "[" + std::to_string(i) + "]";
-        shader.SetUniform3f(indexedName + ".inner.ambient", spLights[i].Inner.Ambient());
-        shader.SetUniform3f(indexedName + ".inner.diffuse", spLights[i].Inner.Diffuse());
-        shader.SetUniform3f(indexedName + ".inner.specular", spLights[i].Inner.Specular());
+    for (int i = 0; i < count; i++) {
+        SetPointLight(i, ptLights[i]);
+    }
+}
 
-        shader.SetUniform3f(indexedName + ".position", spLights[i].Position);
-        shader.SetUniform3f(indexedName + ".direction", spLights[i].Direction);
-        shader.SetUniform1f(indexedName + ".atten.constant", spLights[i].Atten.Constant);
-        shader.SetUniform1f(indexedName + ".atten.linear", spLights[i].Atten.Linear);
-        shader.SetUniform1f(indexedName + ".atten.quadratic", spLights[i].Atten.Quadratic);
-        shader.SetUniform1f(indexedName + ".dropOff", spLights[i].DropOff);
-        shader.SetUniform1f(indexedName + ".cutOff", spLights[i].CutOff);
+void LightBuffer::SetSpotLight(const unsigned int index, const SpotLight& spLight) {
+    if (index >= MAX_SPOT_LIGHTS) {
+        spdlog::error("[LightBuffer Error] Spot light index {} out of range", index);
+        return;
     }
+
+    PackedSpotLight packed = {
+        packBasicLight(spLight.Inner), spLight.Position, spLight.DropOff, spLight.Direction, spLight.CutOff,
+        packAttenuation(spLight.Atten),
+    };
+    write(&m_Block.SpLights[index], &packed, sizeof(packed));
+}
+
+void LightBuffer::SetSpotLights(const unsigned int numLights, const SpotLight* spLights) {
+    int count = (int)std::min(numLights, MAX_SPOT_LIGHTS);
+    write(&m_Block.NumSpLights, &count, sizeof(count));
+
+    for (int i = 0; i < count; i++) {
+        SetSpotLight(i, spLights[i]);
+    }
+}
+
+/* Upload writes the changed part of the block to the uniform buffer, nothing is uploaded if no light changed */
+void LightBuffer::Upload() {
+    if (!IsDirty()) {
+        return;
+    }
+
+    m_UBO.InsertData(m_DirtyBegin, (const unsigned char*)&m_Block + m_DirtyBegin, m_DirtyEnd - m_DirtyBegin);
+    m_DirtyBegin = sizeof(LightBlock);
+    m_DirtyEnd = 0;
+}
+
+void LightBuffer::Bind(const unsigned int binding) const {
+    m_UBO.BindRange(0, sizeof(LightBlock), binding);
+}
+
+/* write copies the packed data into the block and grows the dirty range if the bytes differ */
+void LightBuffer::write(void* dst, const void* src, const unsigned int size) {
+    if (std::memcmp(dst, src, size) == 0) {
+        return;
+    }
+
+    std::memcpy(dst, src, size);
+    unsigned int offset = (unsigned int)((unsigned char*)dst - (unsigned char*)&m_Block);
+    m_DirtyBegin = std::min(m_DirtyBegin, offset);
+    m_DirtyEnd = std::max(m_DirtyEnd, offset + size);
 }
@@ -0,0 +1,88 @@
+#include <renderer/pixel_format.h>
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define PIXEL_FORMAT_SSE2
+#include <emmintrin.h>
+#endif
+
+/* ChoosePixelFormat keeps the source channel count. There are no core sRGB formats with one or two channels, so grey
+ * images with gamma correction are the only ones expanded to RGBA. */
+PixelFormat ChoosePixelFormat(const int channels, const bool srgb) {
+    switch (channels) {
+        case 1:
+            if (!srgb) {
+                return {GL_R8, GL_RED, 1, {GL_RED, GL_RED, GL_RED, GL_ONE}};
+            }
+            break;
+        case 2:
+            if (!srgb) {
+                return {GL_RG8, GL_RG, 2, {GL_RED, GL_RED, GL_RED, GL_GREEN}};
+            }
+            break;
+        case 3:
+            return {srgb ? (GLenum)GL_SRGB8 : (GLenum)GL_RGB8, GL_RGB, 3, {GL_RED, GL_GREEN, GL_BLUE, GL_ONE}};
+        default:
+            break;
+    }
+
+    return {srgb ? (GLenum)GL_SRGB8_ALPHA8 : (GLenum)GL_RGBA8, GL_RGBA, 4, {GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA}};
+}
+
+void ExpandToRGBA(const unsigned char* src, unsigned char* dst, const size_t texelCount, const int channels) {
+    size_t i = 0;
+    switch (channels) {
+        case 1: {
+#ifdef PIXEL_FORMAT_SSE2
+            // 16 grey texels per iteration: duplicate each byte twice, then OR in an opaque alpha
+            const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+            for (; i + 16 <= texelCount; i += 16) {
+                __m128i grey = _mm_loadu_si128((const __m128i*)(src + i));
+                __m128i lo = _mm_unpacklo_epi8(grey, grey);
+                __m128i hi = _mm_unpackhi_epi8(grey, grey);
+                __m128i* out = (__m128i*)(dst + i * 4);
+                _mm_storeu_si128(out + 0, _mm_or_si128(_mm_unpacklo_epi16(lo, lo), alpha));
+                _mm_storeu_si128(out + 1, _mm_or_si128(_mm_unpackhi_epi16(lo, lo), alpha));
+                _mm_storeu_si128(out + 2, _mm_or_si128(_mm_unpacklo_epi16(hi, hi), alpha));
+                _mm_storeu_si128(out + 3, _mm_or_si128(_mm_unpackhi_epi16(hi, hi), alpha));
+            }
+#endif
+            for (; i < texelCount; i++) {
+                dst[i * 4 + 0] = dst[i * 4 + 1] = dst[i * 4 + 2] = src[i];
+                dst[i * 4 + 3] = 255;
+            }
+            break;
+        }
+        case 2: {
+#ifdef PIXEL_FORMAT_SSE2
+            // 8 grey-alpha texels per iteration: interleave a (grey, grey) pair with the (grey, alpha) pair
+            const __m128i greyMask = _mm_set1_epi16(0x00FF);
+            for (; i + 8 <= texelCount; i += 8) {
+                __m128i greyAlpha = _mm_loadu_si128((const __m128i*)(src + i * 2));
+                __m128i grey = _mm_and_si128(greyAlpha, greyMask);
+                __m128i greyGrey = _mm_or_si128(grey, _mm_slli_epi16(grey, 8));
+                __m128i* out = (__m128i*)(dst + i * 4);
+                _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(greyGrey, greyAlpha));
+                _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(greyGrey, greyAlpha));
+            }
+#endif
+            for (; i < texelCount; i++) {
+                dst[i * 4 + 0] = dst[i * 4 + 1] = dst[i * 4 + 2] = src[i * 2];
+                dst[i * 4 + 3] = src[i * 2 + 1];
+            }
+            break;
+        }
+        case 3:
+            for (; i < texelCount; i++) {
+                dst[i * 4 + 0] = src[i * 3 + 0];
+                dst[i * 4 + 1] = src[i * 3 + 1];
+                dst[i * 4 + 2] = src[i * 3 + 2];
+                dst[i * 4 + 3] = 255;
+            }
+            break;
+        default:
+            std::memcpy(dst, src, texelCount * 4);
+            break;
+    }
+}
@@ -0,0 +1,177 @@
+#include <renderer/program_cache.h>
+
+#include <cstdio>
+#include <fstream>
+
+const uint32_t PROGRAM_BINARY_MAGIC = 0x4E494250;  // "PBIN"
+
+struct ProgramBinaryHeader {
+    uint32_t Magic;
+    uint32_t Format;
+    uint32_t Length;
+};
+
+ProgramCacheInst ProgramCache::s_Instance;
+
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static uint64_t hashString(uint64_t hash, const std::string& str) {
+    // Include the length so that the boundaries between strings are part of the key
+    uint64_t size = str.size();
+    hash = hashBytes(hash, &size, sizeof(size));
+    return hashBytes(hash, str.data(), str.size());
+}
+
+void ProgramCache::SetDirectory(const std::filesystem::path& directory) {
+    s_Instance.m_Directory = directory;
+}
+
+void ProgramCache::SetEnabled(bool enabled) {
+    s_Instance.m_Enabled = enabled;
+}
+
+/* init hashes the driver strings and checks that the driver supports program binaries at all */
+bool ProgramCache::init() {
+    if (s_Instance.m_Initialized) {
+        return s_Instance.m_Enabled;
+    }
+    s_Instance.m_Initialized = true;
+
+    int numFormats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+    if (numFormats == 0) {
+        spdlog::warn("[ProgramCache Warning] Driver supports no program binary formats, cache disabled");
+        s_Instance.m_Enabled = false;
+        return false;
+    }
+
+    uint64_t hash = 14695981039346656037ull;
+    const GLenum names[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    for (GLenum name : names) {
+        const char* str = (const char*)glGetString(name);
+        hash = hashString(hash, str ? std::string(str) : std::string());
+    }
+    s_Instance.m_DriverHash = hash;
+
+    std::error_code ec;
+    std::filesystem::create_directories(s_Instance.m_Directory, ec);
+    if (ec) {
+        spdlog::warn("[ProgramCache Warning] Failed to create cache directory '{}': {}",
+                     s_Instance.m_Directory.string(), ec.message());
+        s_Instance.m_Enabled = false;
+    }
+
+    return s_Instance.m_Enabled;
+}
+
+uint64_t ProgramCache::ComputeKey(const std::vector<std::string>& sources) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const std::string& source : sources) {
+        hash = hashString(hash, source);
+    }
+    return hash;
+}
+
+std::filesystem::path ProgramCache::pathForKey(uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)(key ^ s_Instance.m_DriverHash));
+    return s_Instance.m_Directory / name;
+}
+
+bool ProgramCache::Load(uint64_t key, unsigned int program) {
+    if (!s_Instance.m_Enabled || !init()) {
+        return false;
+    }
+
+    std::ifstream file(pathForKey(key), std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    ProgramBinaryHeader header;
+    std::vector<char> binary;
+    if (file.read((char*)&header, sizeof(header)) && header.Magic == PROGRAM_BINARY_MAGIC) {
+        binary.resize(header.Length);
+        file.read(binary.data(), header.Length);
+    }
+
+    if (binary.empty() || !file) {
+        spdlog::warn("[ProgramCache Warning] Corrupted program binary '{}'", pathForKey(key).string());
+        s_Instance.m_Stats.Rejected++;
+        return false;
+    }
+
+    // The driver may reject binaries, e.g. after an update that kept the version string
+    int result = GL_FALSE;
+    glProgramBinary(program, header.Format, binary.data(), header.Length);
+    glGetProgramiv(program, GL_LINK_STATUS, &result);
+    if (result == GL_FALSE) {
+        spdlog::debug("Program binary '{}' rejected by the driver", pathForKey(key).string());
+        s_Instance.m_Stats.Rejected++;
+        return false;
+    }
+
+    s_Instance.m_Stats.Hits++;
+    return true;
+}
+
+/* Store writes the program binary into a temporary file which is then renamed over the final one, so a crash can
+ * never leave a truncated binary behind */
+void ProgramCache::Store(uint64_t key, unsigned int program) {
+    if (!s_Instance.m_Enabled || !init()) {
+        return;
+    }
+
+    int length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+    ProgramBinaryHeader header = {PROGRAM_BINARY_MAGIC, format, (uint32_t)length};
+
+    std::filesystem::path path = pathForKey(key);
+    std::filesystem::path tmpPath = path;
+    tmpPath += ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        file.write((const char*)&header, sizeof(header));
+        file.write(binary.data(), length);
+        if (!file) {
+            spdlog::warn("[ProgramCache Warning] Failed to write program binary '{}'", tmpPath.string());
+            return;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        spdlog::warn("[ProgramCache Warning] Failed to store program binary '{}': {}", path.string(), ec.message());
+        std::filesystem::remove(tmpPath, ec);
+    }
+}
+
+void ProgramCache::AddLoadTime(double ms) {
+    s_Instance.m_Stats.LoadMs += ms;
+}
+
+void ProgramCache::AddCompileTime(double ms) {
+    s_Instance.m_Stats.Compiled++;
+    s_Instance.m_Stats.CompileMs += ms;
+}
+
+/* LogStats reports how much time went into building programs from the cache (warm) and from source (cold) */
+void ProgramCache::LogStats() {
+    const ProgramCacheStats& stats = s_Instance.m_Stats;
+    spdlog::info("Programs: {} from cache in {:.1f} ms, {} compiled in {:.1f} ms ({} binaries rejected)", stats.Hits,
+                 stats.LoadMs, stats.Compiled, stats.CompileMs, stats.Rejected);
+}
@@ -1,4 +1,5 @@
 #include <common.h>
+#include <renderer/binding_cache.h>
 #include <renderer/rbo.h>
 
 RenderBuffer::RenderBuffer(const RenderBufferType type, const unsigned int width, const unsigned int height)
@@ -10,13 +11,14 @@ RenderBuffer::RenderBuffer(const RenderBufferType type, const unsigned int width
 
 RenderBuffer::~RenderBuffer() {
     spdlog::debug("RenderBuffer {} destroyed", m_ReferenceID);
+    BindingCache::DeleteRenderBuffer(m_ReferenceID);
     glDeleteRenderbuffers(1, &m_ReferenceID);
 }
 
 void RenderBuffer::Bind() const {
-    glBindRenderbuffer(GL_RENDERBUFFER, m_ReferenceID);
+    BindingCache::BindRenderBuffer(m_ReferenceID);
 }
 
 void RenderBuffer::Unbind() const {
-    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    BindingCache::BindRenderBuffer(0);
 }
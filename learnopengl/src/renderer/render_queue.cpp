@@ -0,0 +1,205 @@
+#include <common.h>
+#include <renderer/render_queue.h>
+
+#include <algorithm>
+
+// Sort key layout (most significant bit first):
+//   opaque:      | pass (4) | translucent = 0 (1) | program (10) | material (14) | depth (24) | unused (11) |
+//   translucent: | pass (4) | translucent = 1 (1) | inverted depth (24) | program (10) | material (14) | unused (11) |
+// Opaque draws are grouped by state and then sorted front-to-back, translucent draws are sorted back-to-front.
+const unsigned int KEY_PASS_BITS = 4;
+const unsigned int KEY_PROGRAM_BITS = 10;
+const unsigned int KEY_MATERIAL_BITS = 14;
+const unsigned int KEY_DEPTH_BITS = 24;
+
+const uint64_t KEY_PASS_MASK = (1ull << KEY_PASS_BITS) - 1;
+const uint64_t KEY_PROGRAM_MASK = (1ull << KEY_PROGRAM_BITS) - 1;
+const uint64_t KEY_MATERIAL_MASK = (1ull << KEY_MATERIAL_BITS) - 1;
+const uint64_t KEY_DEPTH_MASK = (1ull << KEY_DEPTH_BITS) - 1;
+
+void RenderQueue::SetView(const glm::vec3& viewPosition, const float farPlane) {
+    m_ViewPosition = viewPosition;
+    m_FarPlane = farPlane;
+}
+
+void RenderQueue::Submit(const DrawCommand& cmd) {
+    unsigned int materialID = internMaterial(cmd);
+    m_Keys.push_back(buildSortKey(cmd, materialID));
+    m_Commands.push_back({cmd, materialID});
+}
+
+void RenderQueue::Submit(const Mesh& mesh, Shader& shader, const glm::mat4& model, const unsigned int pass) {
+    const GeometryRange& range = mesh.GetGeometry();
+    DrawCommand cmd;
+    cmd.VAO = &mesh.GetVAO();
+    cmd.IBO = &mesh.GetIBO();
+    cmd.Count = range.IndexCount;
+    cmd.FirstIndex = range.FirstIndex;
+    cmd.BaseVertex = range.BaseVertex;
+    cmd.Program = &shader;
+    cmd.SourceMesh = &mesh;
+    cmd.Model = model;
+    cmd.Pass = pass;
+    Submit(cmd);
+}
+
+void RenderQueue::Submit(const Model& model, Shader& shader, const glm::mat4& modelMatrix, const unsigned int pass) {
+    for (const std::shared_ptr<Mesh>& mesh : model.GetMeshes()) {
+        Submit(*mesh, shader, modelMatrix, pass);
+    }
+}
+
+/* Flush sorts all submitted commands by their keys and issues them, only switching program and material state when
+ * it actually changes between two consecutive draws. The interned program and material IDs are only valid for the
+ * commands of one flush, so they are reset along with the commands. */
+void RenderQueue::Flush(const Renderer& renderer) {
+    m_Stats = RenderQueueStats();
+    if (m_Commands.empty()) {
+        return;
+    }
+
+    radixSort();
+
+    Shader* currProgram = nullptr;
+    UniformHandle modelUniform;
+    unsigned int currMaterial = UINT32_MAX;
+    for (unsigned int idx : m_Order) {
+        const QueuedCommand& qc = m_Commands[idx];
+        const DrawCommand& cmd = qc.Command;
+
+        if (cmd.Program != currProgram) {
+            cmd.Program->Bind();
+            currProgram = cmd.Program;
+            modelUniform = currProgram->GetUniform("u_Model"_uniform);
+            // Sampler uniforms are per-program, so the material has to be set up again
+            currMaterial = UINT32_MAX;
+            m_Stats.ProgramSwitches++;
+        }
+
+        if (qc.MaterialID != currMaterial) {
+            if (cmd.SourceMesh) {
+                cmd.SourceMesh->SetupDraw(*cmd.Program);
+            } else {
+                for (unsigned int i = 0; i < MAX_DRAW_TEXTURES; i++) {
+                    if (cmd.Textures[i]) {
+                        cmd.Textures[i]->Bind(i);
+                    }
+                }
+            }
+            currMaterial = qc.MaterialID;
+            m_Stats.MaterialSwitches++;
+        }
+
+        currProgram->SetUniformMatrix4f(modelUniform, cmd.Model);
+        if (cmd.IBO) {
+            unsigned int count = cmd.Count > 0 ? cmd.Count : cmd.IBO->GetCount();
+            renderer.Draw(*cmd.VAO, *cmd.IBO, count, cmd.FirstIndex, cmd.BaseVertex);
+        } else {
+            renderer.Draw(*cmd.VAO, cmd.Count);
+        }
+        m_Stats.DrawCalls++;
+    }
+
+    m_Commands.clear();
+    m_Keys.clear();
+    m_ProgramIDs.clear();
+    m_MaterialIDs.clear();
+}
+
+uint64_t RenderQueue::buildSortKey(const DrawCommand& cmd, const unsigned int materialID) {
+    std::map<unsigned int, unsigned int>::iterator it = m_ProgramIDs.find(cmd.Program->GetReferenceID());
+    if (it == m_ProgramIDs.end()) {
+        it = m_ProgramIDs.emplace(cmd.Program->GetReferenceID(), (unsigned int)m_ProgramIDs.size()).first;
+    }
+
+    uint64_t pass = cmd.Pass & KEY_PASS_MASK;
+    uint64_t program = it->second & KEY_PROGRAM_MASK;
+    uint64_t material = materialID & KEY_MATERIAL_MASK;
+
+    // Quantize distance from the viewer into the depth range of the key
+    float dist = glm::length(glm::vec3(cmd.Model[3]) - m_ViewPosition) / m_FarPlane;
+    uint64_t depth = (uint64_t)(std::clamp(dist, 0.0f, 1.0f) * (float)KEY_DEPTH_MASK);
+
+    uint64_t key = pass << 60;
+    if (cmd.Translucent) {
+        key |= 1ull << 59;
+        key |= (KEY_DEPTH_MASK - depth) << 35;
+        key |= program << 25;
+        key |= material << 11;
+    } else {
+        key |= program << 49;
+        key |= material << 35;
+        key |= depth << 11;
+    }
+
+    return key;
+}
+
+unsigned int RenderQueue::internMaterial(const DrawCommand& cmd) {
+    // Textures are identified by address, their GL names change when the texture cache evicts and reloads them
+    std::array<uintptr_t, MAX_DRAW_TEXTURES + 1> textureIDs = {};
+    if (cmd.SourceMesh) {
+        const std::vector<std::shared_ptr<Texture>>& textures = cmd.SourceMesh->GetTextures();
+        textureIDs[0] = 1;
+        if (textures.size() > MAX_DRAW_TEXTURES) {
+            // Too many textures to describe the material, treat the mesh as its own material
+            textureIDs[0] = 2;
+            textureIDs[1] = (uintptr_t)cmd.SourceMesh;
+        } else {
+            for (unsigned int i = 0; i < textures.size(); i++) {
+                textureIDs[i + 1] = (uintptr_t)textures[i].get();
+            }
+        }
+    } else {
+        for (unsigned int i = 0; i < MAX_DRAW_TEXTURES; i++) {
+            textureIDs[i + 1] = (uintptr_t)cmd.Textures[i];
+        }
+    }
+
+    std::map<std::array<uintptr_t, MAX_DRAW_TEXTURES + 1>, unsigned int>::iterator it =
+        m_MaterialIDs.find(textureIDs);
+    if (it == m_MaterialIDs.end()) {
+        it = m_MaterialIDs.emplace(textureIDs, (unsigned int)m_MaterialIDs.size()).first;
+    }
+
+    return it->second;
+}
+
+/* radixSort does a LSD radix sort of the command indices by their 64-bit keys, 8 bits per pass. Passes where every key
+ * shares the same digit are skipped. */
+void RenderQueue::radixSort() {
+    unsigned int size = (unsigned int)m_Keys.size();
+    m_Order.resize(size);
+    m_OrderTemp.resize(size);
+    m_KeysTemp.resize(size);
+    for (unsigned int i = 0; i < size; i++) {
+        m_Order[i] = i;
+    }
+
+    for (unsigned int shift = 0; shift < 64; shift += 8) {
+        unsigned int histogram[256] = {};
+        for (unsigned int i = 0; i < size; i++) {
+            histogram[(m_Keys[i] >> shift) & 0xFF]++;
+        }
+
+        if (histogram[(m_Keys[0] >> shift) & 0xFF] == size) {
+            continue;
+        }
+
+        unsigned int offsets[256];
+        unsigned int sum = 0;
+        for (unsigned int i = 0; i < 256; i++) {
+            offsets[i] = sum;
+            sum += histogram[i];
+        }
+
+        for (unsigned int i = 0; i < size; i++) {
+            unsigned int dst = offsets[(m_Keys[i] >> shift) & 0xFF]++;
+            m_KeysTemp[dst] = m_Keys[i];
+            m_OrderTemp[dst] = m_Order[i];
+        }
+
+        std::swap(m_Keys, m_KeysTemp);
+        std::swap(m_Order, m_OrderTemp);
+    }
+}
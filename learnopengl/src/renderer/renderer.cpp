@@ -2,9 +2,17 @@
 #include <renderer/renderer.h>
 
 void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib) const {
+    Draw(va, ib, ib.GetCount(), 0, 0);
+}
+
+/* Draw draws count indices starting at firstIndex, with baseVertex added to every index. Used for geometry that is a
+ * range of a shared arena page. */
+void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const unsigned int count,
+                    const unsigned int firstIndex, const int baseVertex) const {
     va.Bind();
     ib.Bind();
-    glDrawElements(GL_TRIANGLES, ib.GetCount(), GL_UNSIGNED_INT, nullptr);
+    glDrawElementsBaseVertex(GL_TRIANGLES, count, ib.GetType(), (const void*)(size_t)(firstIndex * ib.GetIndexSize()),
+                             baseVertex);
 }
 
 void Renderer::Draw(const VertexArray& va, const unsigned int count) const {
@@ -12,22 +20,74 @@ void Renderer::Draw(const VertexArray& va, const unsigned int count) const {
     glDrawArrays(GL_TRIANGLES, 0, count);
 }
 
+/* Draw draws several index ranges of the same buffers with one glMultiDrawElementsBaseVertex */
+void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const std::vector<GeometryRange>& ranges) const {
+    std::vector<GLsizei> counts(ranges.size());
+    std::vector<const void*> offsets(ranges.size());
+    std::vector<GLint> baseVertices(ranges.size());
+    for (size_t i = 0; i < ranges.size(); i++) {
+        counts[i] = (GLsizei)ranges[i].IndexCount;
+        offsets[i] = (const void*)(size_t)(ranges[i].FirstIndex * ib.GetIndexSize());
+        baseVertices[i] = ranges[i].BaseVertex;
+    }
+
+    va.Bind();
+    ib.Bind();
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts.data(), ib.GetType(), offsets.data(), (GLsizei)ranges.size(),
+                                  baseVertices.data());
+}
+
 void Renderer::Draw(const Mesh& mesh, Shader& shader) const {
+    const GeometryRange& range = mesh.GetGeometry();
     mesh.SetupDraw(shader);
-    Draw(mesh.GetVAO(), mesh.GetIBO());
+    Draw(mesh.GetVAO(), mesh.GetIBO(), range.IndexCount, range.FirstIndex, range.BaseVertex);
 }
 
 void Renderer::Draw(const Model& model, Shader& shader) const {
-    model.SetupDraw(shader);
-    for (std::shared_ptr<Mesh> mesh : model.GetMeshes()) {
+    for (const std::shared_ptr<Mesh>& mesh : model.GetMeshes()) {
         Draw(*mesh, shader);
     }
 }
 
+/* DrawCulled draws only the meshlets of the model inside the view frustum and facing the camera, with one multi-draw
+ * per mesh. Normal cone culling assumes back faces are culled. */
+void Renderer::DrawCulled(const Model& model, Shader& shader, const glm::mat4& modelMatrix,
+                          const glm::mat4& viewProjection, const glm::vec3& cameraPosition) const {
+    // Cull in model space, the planes of viewProjection * modelMatrix are the frustum as seen from the model
+    Frustum frustum = ExtractFrustum(viewProjection * modelMatrix);
+    glm::vec3 localCamera = glm::vec3(glm::inverse(modelMatrix) * glm::vec4(cameraPosition, 1.0f));
+
+    std::vector<GeometryRange> visible;
+    for (const std::shared_ptr<Mesh>& mesh : model.GetMeshes()) {
+        visible.clear();
+        mesh->CullMeshlets(frustum, localCamera, visible);
+        if (visible.empty()) {
+            continue;
+        }
+
+        mesh->SetupDraw(shader);
+        Draw(mesh->GetVAO(), mesh->GetIBO(), visible);
+    }
+}
+
+/* DrawIndirect draws all meshes of the model with one multi-draw per indirect batch, the shader has to read the
+ * per-mesh material through gl_DrawID. */
+void Renderer::DrawIndirect(const Model& model, Shader& shader, const unsigned int lod) const {
+    DrawInstancedIndirect(model, shader, 1, lod);
+}
+
 void Renderer::DrawInstanced(const VertexArray& va, const IndexBuffer& ib, const unsigned int instances) const {
+    DrawInstanced(va, ib, ib.GetCount(), 0, 0, instances);
+}
+
+void Renderer::DrawInstanced(const VertexArray& va, const IndexBuffer& ib, const unsigned int count,
+                             const unsigned int firstIndex, const int baseVertex, const unsigned int instances,
+                             const unsigned int baseInstance) const {
     va.Bind();
     ib.Bind();
-    glDrawElementsInstanced(GL_TRIANGLES, ib.GetCount(), GL_UNSIGNED_INT, nullptr, instances);
+    glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, count, ib.GetType(),
+                                                  (const void*)(size_t)(firstIndex * ib.GetIndexSize()), instances,
+                                                  baseVertex, baseInstance);
 }
 
 void Renderer::DrawInstanced(const VertexArray& va, const unsigned int count, const unsigned int instances) const {
@@ -35,15 +95,33 @@ void Renderer::DrawInstanced(const VertexArray& va, const unsigned int count, co
     glDrawArraysInstanced(GL_TRIANGLES, 0, count, instances);
 }
 
-void Renderer::DrawInstanced(const Mesh& mesh, Shader& shader, const unsigned int instances) const {
+void Renderer::DrawInstanced(const Mesh& mesh, Shader& shader, const unsigned int instances, const unsigned int lod,
+                             const unsigned int baseInstance) const {
+    const GeometryRange& range = mesh.GetLod(lod);
     mesh.SetupDraw(shader);
-    DrawInstanced(mesh.GetVAO(), mesh.GetIBO(), instances);
+    DrawInstanced(mesh.GetVAO(), mesh.GetIBO(), range.IndexCount, range.FirstIndex, range.BaseVertex, instances,
+                  baseInstance);
+}
+
+void Renderer::DrawInstanced(const Model& model, Shader& shader, const unsigned int instances, const unsigned int lod,
+                             const unsigned int baseInstance) const {
+    for (const std::shared_ptr<Mesh>& mesh : model.GetMeshes()) {
+        DrawInstanced(*mesh, shader, instances, lod, baseInstance);
+    }
 }
 
-void Renderer::DrawInstanced(const Model& model, Shader& shader, const unsigned int instances) const {
-    model.SetupDraw(shader);
-    for (std::shared_ptr<Mesh> mesh : model.GetMeshes()) {
-        DrawInstanced(*mesh, shader, instances);
+void Renderer::DrawInstancedIndirect(const Model& model, Shader& shader, const unsigned int instances,
+                                     const unsigned int lod, const unsigned int baseInstance) const {
+    // Models using more textures than fit into the units of one multi-draw are split into several batches
+    for (unsigned int batch = 0; batch < model.GetIndirectBatchCount(); batch++) {
+        IndirectBuffer& ib = model.GetIndirectBuffer(batch, lod);
+        ib.SetInstanceCount(instances, baseInstance);
+        model.SetupDraw(shader, batch);
+        model.GetVAO().Bind();
+        model.GetIBO().Bind();
+        ib.Bind();
+        // The commands count first indices in elements of the index type, not in bytes
+        glMultiDrawElementsIndirect(GL_TRIANGLES, model.GetIBO().GetType(), nullptr, ib.GetCount(), 0);
     }
 }
 
@@ -0,0 +1,108 @@
+#include <renderer/binding_cache.h>
+#include <renderer/ring_buffer.h>
+
+#include <cstring>
+#include <stdexcept>
+
+DynamicRingBuffer::DynamicRingBuffer(unsigned int regionSize, unsigned int target)
+    : m_ReferenceID(0), m_Target(target), m_Alignment(1), m_Mapped(nullptr), m_Region(0), m_Head(0), m_Fences() {
+    // Allocations are bound with glBindBufferRange, so their offsets must respect the target's offset alignment
+    int alignment = 1;
+    if (target == GL_UNIFORM_BUFFER) {
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    } else if (target == GL_SHADER_STORAGE_BUFFER) {
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    }
+    m_Alignment = alignment > 0 ? (unsigned int)alignment : 1;
+    m_RegionSize = (regionSize + m_Alignment - 1) / m_Alignment * m_Alignment;
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &m_ReferenceID);
+    BindingCache::BindBuffer(m_Target, m_ReferenceID);
+    glBufferStorage(m_Target, m_RegionSize * RING_BUFFER_REGIONS, nullptr, flags);
+    m_Mapped = (unsigned char*)glMapBufferRange(m_Target, 0, m_RegionSize * RING_BUFFER_REGIONS, flags);
+
+    if (!m_Mapped) {
+        spdlog::error("[DynamicRingBuffer Error] Failed to map buffer {}", m_ReferenceID);
+        throw std::runtime_error("Failed to map ring buffer");
+    }
+}
+
+DynamicRingBuffer::~DynamicRingBuffer() {
+    spdlog::debug("DynamicRingBuffer {} destroyed", m_ReferenceID);
+    for (unsigned int i = 0; i < RING_BUFFER_REGIONS; i++) {
+        if (m_Fences[i]) {
+            glDeleteSync(m_Fences[i]);
+        }
+    }
+
+    // Deleting the buffer also unmaps it
+    BindingCache::DeleteBuffer(m_ReferenceID);
+    glDeleteBuffers(1, &m_ReferenceID);
+}
+
+void DynamicRingBuffer::BeginFrame() {
+    m_Region = (m_Region + 1) % RING_BUFFER_REGIONS;
+    m_Head = 0;
+
+    GLsync& fence = m_Fences[m_Region];
+    if (!fence) {
+        return;
+    }
+
+    // Only flush on the first wait, flushing again would be a wasted driver call
+    GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while (true) {
+        GLenum result = glClientWaitSync(fence, waitFlags, 1000000);
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+            break;
+        }
+        if (result == GL_WAIT_FAILED) {
+            spdlog::error("[DynamicRingBuffer Error] Waiting for region {} failed", m_Region);
+            break;
+        }
+        waitFlags = 0;
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void DynamicRingBuffer::EndFrame() {
+    GLsync& fence = m_Fences[m_Region];
+    if (fence) {
+        glDeleteSync(fence);
+    }
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/* Allocate returns the next aligned piece of the current region, the region must be large enough for all allocations
+ * of one frame */
+RingAllocation DynamicRingBuffer::Allocate(unsigned int size) {
+    unsigned int head = (m_Head + m_Alignment - 1) / m_Alignment * m_Alignment;
+    if (head + size > m_RegionSize) {
+        spdlog::error("[DynamicRingBuffer Error] Region of {} bytes exhausted ({} requested)", m_RegionSize, size);
+        throw std::runtime_error("Ring buffer region exhausted");
+    }
+    m_Head = head + size;
+
+    RingAllocation allocation;
+    allocation.Offset = m_Region * m_RegionSize + head;
+    allocation.Data = m_Mapped + allocation.Offset;
+    allocation.Size = size;
+
+    return allocation;
+}
+
+RingAllocation DynamicRingBuffer::Write(const void* data, unsigned int size) {
+    RingAllocation allocation = Allocate(size);
+    std::memcpy(allocation.Data, data, size);
+
+    return allocation;
+}
+
+void DynamicRingBuffer::BindRange(const RingAllocation& allocation, unsigned int binding) const {
+    glBindBufferRange(m_Target, binding, m_ReferenceID, allocation.Offset, allocation.Size);
+    // Binding a range also binds the buffer to the generic target
+    BindingCache::TrackBuffer(m_Target, m_ReferenceID);
+}
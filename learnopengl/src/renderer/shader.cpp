@@ -1,12 +1,17 @@
 #include <common.h>
+#include <core/time.h>
+#include <renderer/binding_cache.h>
+#include <renderer/program_cache.h>
 #include <renderer/shader.h>
+#include <renderer/shader_compiler.h>
 
 #include <fstream>
 #include <glm/gtc/type_ptr.hpp>
 #include <sstream>
 
-/* parseShader parses the shader source code from the filepath */
-const std::string Shader::parseShader(const std::string &filePath) {
+/* parseShader parses the shader source code from the filepath, the defines are inserted right after the #version line
+ * (which has to come first) */
+const std::string Shader::parseShader(const std::string &filePath, const std::vector<std::string> &defines) {
     std::ifstream stream(filePath);
     if (stream.fail()) {
         spdlog::error("[Shader Error] Shader file '{}' does not exist", filePath);
@@ -15,25 +20,48 @@ const std::string Shader::parseShader(const std::string &filePath) {
 
     std::string line;
     std::stringstream ss;
+    bool injected = defines.empty();
+    unsigned int lineNr = 0;
     while (getline(stream, line)) {
+        lineNr++;
         ss << line << '\n';
+
+        if (!injected && line.rfind("#version", 0) == 0) {
+            for (const std::string &define : defines) {
+                ss << "#define " << define << '\n';
+            }
+            // Keep the line numbers of compile errors matching the file
+            ss << "#line " << lineNr + 1 << '\n';
+            injected = true;
+        }
+    }
+
+    if (!injected) {
+        spdlog::warn("[Shader Warning] Shader file '{}' has no #version line, defines ignored", filePath);
     }
 
     return ss.str();
 }
 
-/* compileShader compiles the shader based on type from the provided source string and returns the ID */
+/* compileShader submits the shader source of the given type for compilation and returns the ID, the status is only
+ * checked once the program is needed */
 unsigned int Shader::compileShader(const unsigned int type, const std::string &sourceVal) {
     unsigned int id = glCreateShader(type);
     const char *src = sourceVal.c_str();
     glShaderSource(id, 1, &src, nullptr);
     glCompileShader(id);
 
+    return id;
+}
+
+/* checkShader throws if the shader failed to compile */
+void Shader::checkShader(const unsigned int id) const {
     // Check shader compilation error and print if any
     int result;
     glGetShaderiv(id, GL_COMPILE_STATUS, &result);
     if (result == GL_FALSE) {
-        int length;
+        int type, length;
+        glGetShaderiv(id, GL_SHADER_TYPE, &type);
         glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
 
         char *message = (char *)alloca(length * sizeof(char));
@@ -41,8 +69,6 @@ unsigned int Shader::compileShader(const unsigned int type, const std::string &s
         spdlog::error("[Shader Error] Failed to compile shader (type {}): {}", type, message);
         throw "Shader compilation failed";
     }
-
-    return id;
 }
 
 unsigned int Shader::createProgram(unsigned int vertexShader, unsigned int fragmentShader,
@@ -55,8 +81,17 @@ unsigned int Shader::createProgram(unsigned int vertexShader, unsigned int fragm
         glAttachShader(program, geometryShader);
     }
 
-    int result;
+    if (ProgramCache::IsEnabled()) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
     glLinkProgram(program);
+    return program;
+}
+
+/* checkProgram throws if the program failed to link (or to validate in debug builds) */
+void Shader::checkProgram(const unsigned int program) const {
+    int result;
     glGetProgramiv(program, GL_LINK_STATUS, &result);
     if (result == GL_FALSE) {
         int length;
@@ -68,6 +103,8 @@ unsigned int Shader::createProgram(unsigned int vertexShader, unsigned int fragm
         throw "Shader program linkage failed";
     }
 
+#ifdef _DEBUG
+    // Validation only reports on the current GL state, it is a debugging aid
     glValidateProgram(program);
     glGetProgramiv(program, GL_VALIDATE_STATUS, &result);
     if (result == GL_FALSE) {
@@ -79,85 +116,292 @@ unsigned int Shader::createProgram(unsigned int vertexShader, unsigned int fragm
         spdlog::error("[Shader Error] Failed to validate shader program: {}", message);
         throw "Shader program validation failed";
     }
-
-    return program;
+#endif
 }
 
-/* Shader compiles the shaders from provided sources and links it to a program */
+/* Shader loads the program binary from the program cache if the sources were built before. Otherwise it submits the
+ * shaders for compilation and linking without waiting, the program is finished on first use or by
+ * ShaderCompiler::WaitAll. */
 Shader::Shader(const std::string &vertexFilePath, const std::string &fragmentFilePath,
-               const std::string &geometryFilePath)
-    : m_ReferenceID(0) {
-    // Parse and compile each shader
-    unsigned int vs = compileShader(GL_VERTEX_SHADER, Shader::parseShader(vertexFilePath));
-    unsigned int fs = compileShader(GL_FRAGMENT_SHADER, Shader::parseShader(fragmentFilePath));
-    unsigned int gs = 0;
-    if (geometryFilePath != "") {
-        gs = compileShader(GL_GEOMETRY_SHADER, Shader::parseShader(geometryFilePath));
+               const std::string &geometryFilePath, const std::vector<std::string> &defines)
+    : m_ReferenceID(0), m_Pending(false), m_PendingShaders(), m_CacheKey(0), m_SubmitTime(0.0) {
+    double start = Time::GetTime();
+    // Defines are part of the sources, so every variant gets its own program cache entry
+    std::string vsSource = Shader::parseShader(vertexFilePath, defines);
+    std::string fsSource = Shader::parseShader(fragmentFilePath, defines);
+    std::string gsSource = geometryFilePath != "" ? Shader::parseShader(geometryFilePath, defines) : "";
+    m_CacheKey = ProgramCache::ComputeKey({vsSource, fsSource, gsSource});
+
+    unsigned int program = glCreateProgram();
+    if (ProgramCache::Load(m_CacheKey, program)) {
+        ProgramCache::AddLoadTime((Time::GetTime() - start) * 1000.0);
+        m_ReferenceID = program;
+        reflectUniforms();
+        return;
+    }
+    glDeleteProgram(program);
+
+    // Submit each shader and the program, the compiler threads have to be set before the first compile
+    ShaderCompiler::Init();
+    m_PendingShaders[0] = compileShader(GL_VERTEX_SHADER, vsSource);
+    m_PendingShaders[1] = compileShader(GL_FRAGMENT_SHADER, fsSource);
+    if (gsSource != "") {
+        m_PendingShaders[2] = compileShader(GL_GEOMETRY_SHADER, gsSource);
     }
+    m_ReferenceID = createProgram(m_PendingShaders[0], m_PendingShaders[1], m_PendingShaders[2]);
 
-    // Create shader program
-    unsigned int program = createProgram(vs, fs, gs);
+    m_Pending = true;
+    ShaderCompiler::Submit(this);
+    m_SubmitTime = Time::GetTime() - start;
+}
+
+/* IsReady returns whether the program can be finished without blocking. Without parallel compile support there is no
+ * way to tell, so it always reports ready. */
+bool Shader::IsReady() const {
+    if (!m_Pending || !ShaderCompiler::IsParallel()) {
+        return true;
+    }
+
+    int done = GL_FALSE;
+    glGetProgramiv(m_ReferenceID, GL_COMPLETION_STATUS_KHR, &done);
+    return done == GL_TRUE;
+}
+
+/* Wait finishes a pending program: checks compile and link status, stores the binary and reflects the uniforms */
+void Shader::Wait() const {
+    if (!m_Pending) {
+        return;
+    }
+    m_Pending = false;
+    ShaderCompiler::Remove(this);
+
+    // Only the submit and the status checks count as compile time, not the frames in between or the cache write
+    double start = Time::GetTime();
+    for (unsigned int shader : m_PendingShaders) {
+        if (shader > 0) {
+            checkShader(shader);
+        }
+    }
+    checkProgram(m_ReferenceID);
 
     // We can clear shader intermediates after linking them to program
-    glDeleteShader(vs);
-    glDeleteShader(fs);
-    if (gs > 0) {
-        glDeleteShader(gs);
+    for (unsigned int& shader : m_PendingShaders) {
+        if (shader > 0) {
+            glDetachShader(m_ReferenceID, shader);
+            glDeleteShader(shader);
+            shader = 0;
+        }
     }
 
-    m_ReferenceID = program;
+    ProgramCache::AddCompileTime((m_SubmitTime + Time::GetTime() - start) * 1000.0);
+    ProgramCache::Store(m_CacheKey, m_ReferenceID);
+    reflectUniforms();
 }
 
 Shader::~Shader() {
+    if (m_Pending) {
+        ShaderCompiler::Remove(this);
+        for (unsigned int shader : m_PendingShaders) {
+            if (shader > 0) {
+                glDeleteShader(shader);
+            }
+        }
+    }
+#ifdef _DEBUG
+    ReportUnsetUniforms();
+#endif
+    BindingCache::DeleteProgram(m_ReferenceID);
     glDeleteProgram(m_ReferenceID);
 }
 
 void Shader::Bind() const {
-    glUseProgram(m_ReferenceID);
+    Wait();
+    BindingCache::BindProgram(m_ReferenceID);
 }
 
 void Shader::Unbind() const {
-    glUseProgram(0);
+    BindingCache::BindProgram(0);
+}
+
+/* reflectUniforms enumerates the active uniforms and uniform blocks of the linked program, so that uniform lookups
+ * never have to reach the driver */
+void Shader::reflectUniforms() const {
+    int count = 0;
+    int maxNameLength = 0;
+    glGetProgramInterfaceiv(m_ReferenceID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+    glGetProgramInterfaceiv(m_ReferenceID, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+
+    std::string name(maxNameLength, '\0');
+    const GLenum props[] = {GL_BLOCK_INDEX, GL_LOCATION, GL_TYPE, GL_ARRAY_SIZE};
+    for (int i = 0; i < count; i++) {
+        int values[4];
+        glGetProgramResourceiv(m_ReferenceID, GL_UNIFORM, i, 4, props, 4, nullptr, values);
+        // Members of uniform blocks have no location, they are set through the block's buffer
+        if (values[0] != -1) {
+            continue;
+        }
+
+        int length = 0;
+        glGetProgramResourceName(m_ReferenceID, GL_UNIFORM, i, maxNameLength, &length, name.data());
+        std::string uniformName = name.substr(0, length);
+        unsigned int index = addUniform(uniformName, values[1], values[2], values[3]);
+
+        // Arrays are reported as "name[0]", make the plain name resolve to the same uniform
+        if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0) {
+            m_UniformIndices.emplace(HashUniformName(uniformName.substr(0, uniformName.size() - 3)), index);
+        }
+    }
+
+    glGetProgramInterfaceiv(m_ReferenceID, GL_UNIFORM_BLOCK, GL_ACTIVE_RESOURCES, &count);
+    glGetProgramInterfaceiv(m_ReferenceID, GL_UNIFORM_BLOCK, GL_MAX_NAME_LENGTH, &maxNameLength);
+    name.assign(maxNameLength, '\0');
+    const GLenum blockProps[] = {GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE};
+    for (int i = 0; i < count; i++) {
+        int values[2];
+        glGetProgramResourceiv(m_ReferenceID, GL_UNIFORM_BLOCK, i, 2, blockProps, 2, nullptr, values);
+
+        int length = 0;
+        glGetProgramResourceName(m_ReferenceID, GL_UNIFORM_BLOCK, i, maxNameLength, &length, name.data());
+        m_UniformBlocks.push_back({name.substr(0, length), values[0], values[1]});
+    }
+
+    spdlog::debug("Shader {} has {} uniforms and {} uniform blocks", m_ReferenceID, m_Uniforms.size(),
+                  m_UniformBlocks.size());
+}
+
+unsigned int Shader::addUniform(const std::string &name, int location, unsigned int type, int arraySize) const {
+    uint32_t hash = HashUniformName(name);
+    std::unordered_map<uint32_t, unsigned int>::iterator it = m_UniformIndices.find(hash);
+    if (it != m_UniformIndices.end()) {
+        spdlog::error("[Shader Error] Uniform '{}' has the same hash as '{}'", name, m_Uniforms[it->second].Name);
+        return it->second;
+    }
+
+    unsigned int index = (unsigned int)m_Uniforms.size();
+    m_UniformIndices.emplace(hash, index);
+    m_Uniforms.push_back({name, location, type, arraySize, false});
+    return index;
 }
 
-void Shader::SetUniform1f(const std::string &name, float value) {
-    glUniform1f(getUniformLocation(name), value);
+/* GetUniform resolves a uniform name to a handle. Names that are not reflected (e.g. single array elements) are
+ * looked up once and remembered, unknown names give an invalid handle. */
+UniformHandle Shader::GetUniform(UniformName name) {
+    Wait();
+    std::unordered_map<uint32_t, unsigned int>::iterator it = m_UniformIndices.find(name.Hash);
+    if (it != m_UniformIndices.end()) {
+        return UniformHandle{m_Uniforms[it->second].Location, it->second};
+    }
+
+    std::string nameStr(name.Name);
+    int location = glGetUniformLocation(m_ReferenceID, nameStr.c_str());
+    if (location == -1) {
+        spdlog::warn("[Shader Warning] Uniform '{}' doesn't exist!", nameStr);
+    }
+
+    unsigned int index = (unsigned int)m_Uniforms.size();
+    m_UniformIndices.emplace(name.Hash, index);
+    // Not reflected, so it is never reported as unset
+    m_Uniforms.push_back({nameStr, location, 0, 1, true});
+    return UniformHandle{location, index};
 }
 
-void Shader::SetUniform1i(const std::string &name, int value) {
-    glUniform1i(getUniformLocation(name), value);
+int Shader::GetUniformBlockBinding(std::string_view name) const {
+    Wait();
+    for (const UniformBlockInfo &block : m_UniformBlocks) {
+        if (block.Name == name) {
+            return block.Binding;
+        }
+    }
+
+    return -1;
 }
 
-void Shader::SetUniform3f(const std::string &name, float v0, float v1, float v2) {
-    glUniform3f(getUniformLocation(name), v0, v1, v2);
+void Shader::ReportUnsetUniforms() const {
+#ifdef _DEBUG
+    for (const UniformInfo &uniform : m_Uniforms) {
+        if (!uniform.Set && uniform.Location != -1) {
+            spdlog::warn("[Shader Warning] Uniform '{}' of shader {} was never set", uniform.Name, m_ReferenceID);
+        }
+    }
+#endif
 }
 
-void Shader::SetUniform3f(const std::string &name, glm::vec3 value) {
-    glUniform3fv(getUniformLocation(name), 1, glm::value_ptr(value));
+void Shader::markSet([[maybe_unused]] UniformHandle handle) {
+#ifdef _DEBUG
+    if (handle.Index < m_Uniforms.size()) {
+        m_Uniforms[handle.Index].Set = true;
+    }
+#endif
 }
 
-void Shader::SetUniform4f(const std::string &name, float v0, float v1, float v2, float v3) {
-    glUniform4f(getUniformLocation(name), v0, v1, v2, v3);
+void Shader::SetUniform1f(UniformName name, float value) {
+    SetUniform1f(GetUniform(name), value);
 }
 
-void Shader::SetUniform4f(const std::string &name, glm::vec4 value) {
-    glUniform4fv(getUniformLocation(name), 1, glm::value_ptr(value));
+void Shader::SetUniform1i(UniformName name, int value) {
+    SetUniform1i(GetUniform(name), value);
 }
 
-void Shader::SetUniformMatrix4f(const std::string &name, glm::mat4 value) {
-    glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
+void Shader::SetUniform1iv(UniformName name, unsigned int count, const int *values) {
+    SetUniform1iv(GetUniform(name), count, values);
 }
 
-int Shader::getUniformLocation(const std::string &name) {
-    if (m_UniformLocationCache.find(name) != m_UniformLocationCache.end()) {
-        return m_UniformLocationCache[name];
-    }
+void Shader::SetUniform3f(UniformName name, float v0, float v1, float v2) {
+    SetUniform3f(GetUniform(name), v0, v1, v2);
+}
 
-    int location = glGetUniformLocation(m_ReferenceID, name.c_str());
-    if (location == -1) {
-        spdlog::warn("[Shader Warning] Uniform '{}' doesn't exist!", name);
-    }
+void Shader::SetUniform3f(UniformName name, glm::vec3 value) {
+    SetUniform3f(GetUniform(name), value);
+}
+
+void Shader::SetUniform4f(UniformName name, float v0, float v1, float v2, float v3) {
+    SetUniform4f(GetUniform(name), v0, v1, v2, v3);
+}
+
+void Shader::SetUniform4f(UniformName name, glm::vec4 value) {
+    SetUniform4f(GetUniform(name), value);
+}
+
+void Shader::SetUniformMatrix4f(UniformName name, glm::mat4 value) {
+    SetUniformMatrix4f(GetUniform(name), value);
+}
+
+void Shader::SetUniform1f(UniformHandle handle, float value) {
+    markSet(handle);
+    glUniform1f(handle.Location, value);
+}
+
+void Shader::SetUniform1i(UniformHandle handle, int value) {
+    markSet(handle);
+    glUniform1i(handle.Location, value);
+}
+
+void Shader::SetUniform1iv(UniformHandle handle, unsigned int count, const int *values) {
+    markSet(handle);
+    glUniform1iv(handle.Location, count, values);
+}
+
+void Shader::SetUniform3f(UniformHandle handle, float v0, float v1, float v2) {
+    markSet(handle);
+    glUniform3f(handle.Location, v0, v1, v2);
+}
+
+void Shader::SetUniform3f(UniformHandle handle, glm::vec3 value) {
+    markSet(handle);
+    glUniform3fv(handle.Location, 1, glm::value_ptr(value));
+}
+
+void Shader::SetUniform4f(UniformHandle handle, float v0, float v1, float v2, float v3) {
+    markSet(handle);
+    glUniform4f(handle.Location, v0, v1, v2, v3);
+}
+
+void Shader::SetUniform4f(UniformHandle handle, glm::vec4 value) {
+    markSet(handle);
+    glUniform4fv(handle.Location, 1, glm::value_ptr(value));
+}
 
-    m_UniformLocationCache[name] = location;
-    return location;
+void Shader::SetUniformMatrix4f(UniformHandle handle, glm::mat4 value) {
+    markSet(handle);
+    glUniformMatrix4fv(handle.Location, 1, GL_FALSE, glm::value_ptr(value));
 }
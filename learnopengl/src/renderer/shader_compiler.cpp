@@ -0,0 +1,63 @@
+#include <renderer/shader.h>
+#include <renderer/shader_compiler.h>
+
+#include <algorithm>
+
+ShaderCompilerInst ShaderCompiler::s_Instance;
+
+/* Init enables parallel compilation if the driver supports either the KHR or the ARB version of the extension */
+void ShaderCompiler::Init() {
+    if (s_Instance.m_Initialized) {
+        return;
+    }
+    s_Instance.m_Initialized = true;
+
+    PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxThreads = nullptr;
+    if (glfwExtensionSupported("GL_KHR_parallel_shader_compile")) {
+        maxThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+    } else if (glfwExtensionSupported("GL_ARB_parallel_shader_compile")) {
+        maxThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress("glMaxShaderCompilerThreadsARB");
+    }
+
+    if (!maxThreads) {
+        spdlog::debug("Parallel shader compilation not supported, programs are finished on first use");
+        return;
+    }
+
+    maxThreads(s_Instance.m_MaxThreads);
+    s_Instance.m_Parallel = true;
+    spdlog::debug("Parallel shader compilation enabled");
+}
+
+void ShaderCompiler::SetMaxThreads(unsigned int count) {
+    s_Instance.m_MaxThreads = count;
+    s_Instance.m_Initialized = false;
+    Init();
+}
+
+void ShaderCompiler::Submit(const Shader* shader) {
+    s_Instance.m_Pending.push_back(shader);
+}
+
+void ShaderCompiler::Remove(const Shader* shader) {
+    std::vector<const Shader*>& pending = s_Instance.m_Pending;
+    pending.erase(std::remove(pending.begin(), pending.end(), shader), pending.end());
+}
+
+void ShaderCompiler::WaitAll() {
+    // Waiting removes the shader from the pending list
+    std::vector<const Shader*> pending = s_Instance.m_Pending;
+    for (const Shader* shader : pending) {
+        shader->Wait();
+    }
+}
+
+bool ShaderCompiler::AllReady() {
+    for (const Shader* shader : s_Instance.m_Pending) {
+        if (!shader->IsReady()) {
+            return false;
+        }
+    }
+
+    return true;
+}
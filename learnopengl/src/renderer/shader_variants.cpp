@@ -0,0 +1,79 @@
+#include <common.h>
+#include <renderer/shader_variants.h>
+
+#include <stdexcept>
+
+ShaderVariants::ShaderVariants(const std::string &vertexFilePath, const std::string &fragmentFilePath,
+                               const std::vector<VariantOption> &options, const std::string &geometryFilePath)
+    : m_VertexFilePath(vertexFilePath),
+      m_FragmentFilePath(fragmentFilePath),
+      m_GeometryFilePath(geometryFilePath),
+      m_Options(options) {
+    uint64_t stride = 1;
+    for (const VariantOption &option : m_Options) {
+        m_Strides.push_back((uint32_t)stride);
+        stride *= (uint64_t)option.Max + 1;
+        if (stride > (1ull << 32)) {
+            spdlog::error("[ShaderVariants Error] Options of '{}' have more variants than fit a 32-bit key",
+                          fragmentFilePath);
+            throw std::runtime_error("Too many shader variant options");
+        }
+    }
+}
+
+uint32_t ShaderVariants::MakeKey(std::initializer_list<unsigned int> values) const {
+    uint32_t key = 0;
+    unsigned int i = 0;
+    for (unsigned int value : values) {
+        if (i >= m_Options.size()) {
+            break;
+        }
+
+        if (value > m_Options[i].Max) {
+            spdlog::error("[ShaderVariants Error] Value {} of option '{}' exceeds its maximum {}", value,
+                          m_Options[i].Define, m_Options[i].Max);
+            throw std::runtime_error("Shader variant option value out of range");
+        }
+        key += value * m_Strides[i];
+        i++;
+    }
+
+    return key;
+}
+
+void ShaderVariants::Prepare(uint32_t key) {
+    if (m_Variants.find(key) != m_Variants.end()) {
+        return;
+    }
+
+    m_Variants.emplace(key, std::make_unique<Shader>(m_VertexFilePath, m_FragmentFilePath, m_GeometryFilePath,
+                                                     definesForKey(key)));
+}
+
+Shader &ShaderVariants::Get(uint32_t key) {
+    std::unordered_map<uint32_t, std::unique_ptr<Shader>>::iterator it = m_Variants.find(key);
+    if (it == m_Variants.end()) {
+        Prepare(key);
+        it = m_Variants.find(key);
+    }
+
+    return *it->second;
+}
+
+std::vector<std::string> ShaderVariants::definesForKey(uint32_t key) const {
+    std::vector<std::string> defines;
+    for (unsigned int i = 0; i < m_Options.size(); i++) {
+        const VariantOption &option = m_Options[i];
+        uint32_t value = (uint32_t)(((uint64_t)key / m_Strides[i]) % ((uint64_t)option.Max + 1));
+
+        if (option.Max == 1) {
+            if (value) {
+                defines.push_back(option.Define);
+            }
+        } else {
+            defines.push_back(option.Define + " " + std::to_string(value));
+        }
+    }
+
+    return defines;
+}
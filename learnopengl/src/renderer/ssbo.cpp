@@ -0,0 +1,34 @@
+#include <common.h>
+#include <renderer/binding_cache.h>
+#include <renderer/ssbo.h>
+
+ShaderStorageBuffer::ShaderStorageBuffer(const void* data, unsigned int size) : m_ReferenceID(0), m_Size(size) {
+    glGenBuffers(1, &m_ReferenceID);
+    Bind();
+    glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_STATIC_DRAW);
+}
+
+ShaderStorageBuffer::~ShaderStorageBuffer() {
+    spdlog::debug("ShaderStorageBuffer {} destroyed", m_ReferenceID);
+    BindingCache::DeleteBuffer(m_ReferenceID);
+    glDeleteBuffers(1, &m_ReferenceID);
+}
+
+void ShaderStorageBuffer::Bind() const {
+    BindingCache::BindBuffer(GL_SHADER_STORAGE_BUFFER, m_ReferenceID);
+}
+
+void ShaderStorageBuffer::Unbind() const {
+    BindingCache::BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void ShaderStorageBuffer::BindBase(unsigned int binding) const {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, m_ReferenceID);
+    // Binding a base also binds the buffer to the generic shader storage buffer target
+    BindingCache::TrackBuffer(GL_SHADER_STORAGE_BUFFER, m_ReferenceID);
+}
+
+void ShaderStorageBuffer::InsertData(unsigned int offset, const void* data, unsigned int size) const {
+    Bind();
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, size, data);
+}
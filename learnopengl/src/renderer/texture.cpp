@@ -1,8 +1,18 @@
 #include <common.h>
+#include <renderer/binding_cache.h>
+#include <renderer/ktx.h>
+#include <renderer/pixel_format.h>
+#include <renderer/texture_cache.h>
 #include <renderer/texture.h>
+#include <renderer/texture_cooker.h>
+#include <renderer/texture_loader.h>
+#include <renderer/texture_streamer.h>
 #include <stb_image/stb_image.h>
 
+#include <algorithm>
+#include <cmath>
 #include <filesystem>
+#include <unordered_map>
 
 struct X {
     GLenum internalFormat, externalFormat, dataType;
@@ -10,7 +20,7 @@ struct X {
 
 X texInit(const GLenum target, unsigned int* referenceID, const TextureType type, const TextureOptions& options) {
     glGenTextures(1, referenceID);
-    glBindTexture(target, *referenceID);
+    BindingCache::BindTexture(target, *referenceID);
 
     // Texture minification and magnification filters
     glTexParameteri(target, GL_TEXTURE_MIN_FILTER, (GLint)options.MinFilter);
@@ -42,9 +52,148 @@ X texInit(const GLenum target, unsigned int* referenceID, const TextureType type
     return {interFormat, exterFormat, dataType};
 }
 
+unsigned int mipLevelCount(const int width, const int height, const TextureOptions& options) {
+    if (!options.GenerateMipMap) {
+        return 1;
+    }
+
+    return (unsigned int)std::floor(std::log2(std::max(width, height))) + 1;
+}
+
+/* estimateBytes approximates the GPU memory of an uncompressed texture, a full mip chain adds a third */
+size_t estimateBytes(const int width, const int height, const int bytesPerTexel, const TextureOptions& options) {
+    size_t bytes = (size_t)width * height * bytesPerTexel;
+    return options.GenerateMipMap ? bytes * 4 / 3 : bytes;
+}
+
+/* findCookedTexture returns the KTX2 file to load for filePath, or an empty string if there is none. A cooked file next
+ * to the source image is used unless the source was modified after cooking. */
+std::string findCookedTexture(const std::string& filePath) {
+    std::filesystem::path path(filePath);
+    if (path.extension() == ".ktx2") {
+        return filePath;
+    }
+
+    std::filesystem::path cooked(TextureCooker::GetCookedPath(filePath));
+    std::error_code error;
+    if (!std::filesystem::exists(cooked, error)) {
+        return "";
+    }
+    if (std::filesystem::last_write_time(path, error) > std::filesystem::last_write_time(cooked, error)) {
+        spdlog::warn("Cooked texture '{}' is older than its source, loading the source instead", cooked.string());
+        return "";
+    }
+
+    return cooked.string();
+}
+
+/* blockFormatSupported tells whether the driver can sample a block-compressed format directly */
+bool blockFormatSupported(const KtxFormatInfo& format) {
+    static std::unordered_map<std::string, bool> s_Extensions;
+    if (!format.Extension) {
+        return true;
+    }
+
+    std::unordered_map<std::string, bool>::iterator it = s_Extensions.find(format.Extension);
+    if (it == s_Extensions.end()) {
+        bool supported = glfwExtensionSupported(format.Extension);
+        if (!supported) {
+            spdlog::warn("{} not supported, compressed textures are decoded on the CPU", format.Extension);
+        }
+        it = s_Extensions.emplace(format.Extension, supported).first;
+    }
+
+    return it->second;
+}
+
+/* ktxUploadFormat picks the GPU format for the levels of a KTX2 file. Block-compressed levels are expanded to RGBA8 on
+ * the CPU when the driver cannot sample them or when the options ask for uncompressed storage. */
+StreamedFormat ktxUploadFormat(const KtxFormatInfo& format, const TextureOptions& options) {
+    StreamedFormat upload;
+    upload.Compressed = format.Block != BlockFormat::None;
+    upload.Decode =
+        upload.Compressed && (options.Compression == TextureCompression::Disabled || !blockFormatSupported(format));
+    upload.InternalFormat = options.GammaCorrection ? format.SrgbInternalFormat : format.InternalFormat;
+    upload.Format = format.Format;
+    upload.Type = format.Type;
+
+    if (upload.Decode) {
+        bool srgb = format.Block != BlockFormat::BC5 && (format.Srgb || options.GammaCorrection);
+        upload.InternalFormat = srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+    }
+
+    return upload;
+}
+
+/* uploadKtx allocates immutable storage on the bound target and uploads every level straight from the mapped file */
+size_t uploadKtx(const GLenum target, const KtxFile& ktx, const TextureOptions& options) {
+    const KtxFormatInfo& format = ktx.GetFormat();
+    StreamedFormat upload = ktxUploadFormat(format, options);
+    bool compressed = upload.Compressed;
+    bool decode = upload.Decode;
+    GLenum internalFormat = upload.InternalFormat;
+
+    // The file holds the whole mip chain, GenerateMipMap only decides whether it is used
+    unsigned int levels = options.GenerateMipMap ? ktx.GetLevelCount() : 1;
+    glTexStorage2D(target, levels, internalFormat, ktx.GetWidth(), ktx.GetHeight());
+
+    size_t bytes = 0;
+    for (unsigned int level = 0; level < levels; level++) {
+        unsigned int width = std::max(1u, ktx.GetWidth() >> level);
+        unsigned int height = std::max(1u, ktx.GetHeight() >> level);
+        size_t faceSize = KtxImageSize(format, width, height);
+
+        for (unsigned int face = 0; face < ktx.GetFaceCount(); face++) {
+            GLenum imageTarget = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : target;
+            const unsigned char* data = ktx.GetLevel(level).Data + face * faceSize;
+            if (decode) {
+                std::vector<unsigned char> rgba = DecompressImage(format.Block, data, width, height);
+                glTexSubImage2D(imageTarget, level, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+            } else if (compressed) {
+                glCompressedTexSubImage2D(imageTarget, level, 0, 0, width, height, internalFormat, (GLsizei)faceSize,
+                                          data);
+            } else {
+                glTexSubImage2D(imageTarget, level, 0, 0, width, height, format.Format, format.Type, data);
+            }
+            bytes += decode ? (size_t)width * height * 4 : faceSize;
+        }
+    }
+
+    return bytes;
+}
+
+/* uploadPixels defines level 0 of the bound target from 8-bit pixels, expanding them only if the format needs it */
+void uploadPixels(const GLenum imageTarget, const int width, const int height, const unsigned char* pixels,
+                  const int channels, const PixelFormat& format) {
+    std::vector<unsigned char> expanded;
+    if (format.Channels != channels) {
+        expanded.resize((size_t)width * height * 4);
+        ExpandToRGBA(pixels, expanded.data(), (size_t)width * height, channels);
+        pixels = expanded.data();
+    }
+
+    // Rows of one to three channel images are not 4-byte aligned in general
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(imageTarget, 0, format.InternalFormat, width, height, 0, format.Format, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+// Mid grey keeps unloaded diffuse and specular maps from standing out
+const unsigned char PLACEHOLDER_TEXEL[4] = {128, 128, 128, 255};
+
 Texture::Texture(const unsigned int w, const unsigned int h, const unsigned int bpp, const TextureType type,
                  const TextureOptions& options)
-    : m_ReferenceID(0), m_FilePath(""), m_Width(w), m_Height(h), m_BPP(bpp), m_Type(type) {
+    : m_ReferenceID(0),
+      m_FilePath(""),
+      m_Width(w),
+      m_Height(h),
+      m_BPP(bpp),
+      m_Type(type),
+      m_Options(options),
+      m_Loaded(true),
+      m_Async(false),
+      m_GPUBytes(estimateBytes(w, h, 4, options)),
+      m_LastUsedFrame(0) {
     X v = texInit(GL_TEXTURE_2D, &m_ReferenceID, type, options);
 
     // Create texture
@@ -58,75 +207,226 @@ Texture::Texture(const unsigned int w, const unsigned int h, const unsigned int
     Unbind();
 }
 
-Texture::Texture(const std::string& filePath, const TextureType type, const TextureOptions& options)
-    : m_ReferenceID(0), m_FilePath(filePath), m_Width(0), m_Height(0), m_BPP(0), m_Type(type) {
+Texture::Texture(const std::string& filePath, const TextureType type, const TextureOptions& options, const bool async)
+    : m_ReferenceID(0),
+      m_FilePath(filePath),
+      m_Width(0),
+      m_Height(0),
+      m_BPP(0),
+      m_Type(type),
+      m_Options(options),
+      m_Loaded(false),
+      m_Async(async),
+      m_GPUBytes(0),
+      m_LastUsedFrame(0) {
+    load();
+}
+
+/* load creates the GL texture from the file, it runs again when an evicted texture is bound */
+void Texture::load() {
+    // Cooked textures need no decode, so they are always loaded right away
+    std::string cookedPath = findCookedTexture(m_FilePath);
+    if (!cookedPath.empty() && m_Options.Streamed && m_Options.GenerateMipMap) {
+        loadStreamed(cookedPath);
+        return;
+    }
+    if (!cookedPath.empty()) {
+        loadKtx(cookedPath);
+        return;
+    }
+
+    if (m_Async) {
+        X v = texInit(GL_TEXTURE_2D, &m_ReferenceID, m_Type, m_Options);
+        glTexImage2D(GL_TEXTURE_2D, 0, v.internalFormat, 1, 1, 0, v.externalFormat, v.dataType, PLACEHOLDER_TEXEL);
+        Unbind();
+
+        m_Loaded = false;
+        m_GPUBytes = sizeof(PLACEHOLDER_TEXEL);
+        TextureLoader::Submit(this, m_FilePath);
+        return;
+    }
+
     // Flip the image since OpenGL expects image coordinates to start from bottom-left
     stbi_set_flip_vertically_on_load(1);
-    unsigned char* data = stbi_load(filePath.c_str(), &m_Width, &m_Height, &m_BPP, STBI_rgb_alpha);
+    // Keep the channel count of the image, shaders still read RGBA through the swizzle
+    unsigned char* data = stbi_load(m_FilePath.c_str(), &m_Width, &m_Height, &m_BPP, 0);
     if (!data) {
-        spdlog::error("[Texture Error] Texture '{}' failed to load", filePath);
+        spdlog::error("[Texture Error] Texture '{}' failed to load", m_FilePath);
         stbi_image_free(data);
         throw "Cannot load texture image";
     }
 
-    X v = texInit(GL_TEXTURE_2D, &m_ReferenceID, type, options);
+    PixelFormat format = ChoosePixelFormat(m_BPP, m_Options.GammaCorrection);
+    texInit(GL_TEXTURE_2D, &m_ReferenceID, m_Type, m_Options);
+    glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, format.Swizzle);
 
     // Create texture
-    glTexImage2D(GL_TEXTURE_2D, 0, v.internalFormat, m_Width, m_Height, 0, v.externalFormat, v.dataType, data);
+    uploadPixels(GL_TEXTURE_2D, m_Width, m_Height, data, m_BPP, format);
 
     // Generate mip-map
-    if (options.GenerateMipMap) {
+    if (m_Options.GenerateMipMap) {
         glGenerateMipmap(GL_TEXTURE_2D);
     }
 
     // Unbind texture and free data buffer
     Unbind();
     stbi_image_free(data);
+
+    m_Loaded = true;
+    m_GPUBytes = estimateBytes(m_Width, m_Height, format.Channels, m_Options);
 }
 
 Texture::~Texture() {
     spdlog::debug("Texture {} destroyed", m_ReferenceID);
+    if (!m_Loaded) {
+        TextureLoader::Cancel(this);
+    }
+    if (m_Options.Streamed) {
+        TextureStreamer::Unregister(this);
+    }
+    BindingCache::DeleteTexture(m_ReferenceID);
+    glDeleteTextures(1, &m_ReferenceID);
+}
+
+/* Evict releases the GPU storage of a texture loaded from a file, the next Bind() loads it again */
+void Texture::Evict() {
+    if (m_FilePath.empty() || !IsResident()) {
+        return;
+    }
+
+    if (!m_Loaded) {
+        TextureLoader::Cancel(this);
+    }
+    if (m_Options.Streamed) {
+        TextureStreamer::Unregister(this);
+    }
+    BindingCache::DeleteTexture(m_ReferenceID);
     glDeleteTextures(1, &m_ReferenceID);
+    m_ReferenceID = 0;
+    m_Loaded = false;
+    m_GPUBytes = 0;
 }
 
 void Texture::Bind(const unsigned int slot, const bool activate) const {
+    m_LastUsedFrame = TextureCache::GetFrame();
+    if (!IsResident()) {
+        // Residency is not part of the observable state, reloading keeps Bind() const for its callers
+        const_cast<Texture*>(this)->load();
+        TextureCache::NotifyReload(*this);
+    }
+
     if (activate) {
         // Activate the texture in position specified by slot
-        glActiveTexture(GL_TEXTURE0 + slot);
+        BindingCache::BindTextureUnit(slot, GL_TEXTURE_2D, m_ReferenceID);
+    } else {
+        BindingCache::BindTexture(GL_TEXTURE_2D, m_ReferenceID);
     }
-
-    glBindTexture(GL_TEXTURE_2D, m_ReferenceID);
 }
 
 void Texture::Unbind() const {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    BindingCache::BindTexture(GL_TEXTURE_2D, 0);
 }
 
-CubeMap::CubeMap(const std::string filePaths[6], const TextureType type, const TextureOptions& options) : m_Type(type) {
+void Texture::loadKtx(const std::string& filePath) {
+    KtxFile ktx(filePath);
+    if (ktx.GetFaceCount() != 1) {
+        spdlog::error("[Texture Error] Texture '{}' is a cube map", filePath);
+        throw "Cannot load texture image";
+    }
+
+    m_Width = ktx.GetWidth();
+    m_Height = ktx.GetHeight();
+    m_BPP = ktx.GetFormat().Block != BlockFormat::None ? 0 : ktx.GetFormat().BlockBytes;
+    m_Loaded = true;
+
+    texInit(GL_TEXTURE_2D, &m_ReferenceID, m_Type, m_Options);
+    m_GPUBytes = uploadKtx(GL_TEXTURE_2D, ktx, m_Options);
+    Unbind();
+}
+
+/* loadStreamed creates a mutable texture whose levels are managed by TextureStreamer, only the coarse tail of the mip
+ * chain is uploaded here */
+void Texture::loadStreamed(const std::string& filePath) {
+    std::shared_ptr<KtxFile> ktx = std::make_shared<KtxFile>(filePath);
+    if (ktx->GetFaceCount() != 1) {
+        spdlog::error("[Texture Error] Texture '{}' is a cube map", filePath);
+        throw "Cannot load texture image";
+    }
+
+    m_Width = ktx->GetWidth();
+    m_Height = ktx->GetHeight();
+    m_BPP = ktx->GetFormat().Block != BlockFormat::None ? 0 : ktx->GetFormat().BlockBytes;
+    m_Loaded = true;
+
+    texInit(GL_TEXTURE_2D, &m_ReferenceID, m_Type, m_Options);
+    Unbind();
+    TextureStreamer::Register(this, ktx, ktxUploadFormat(ktx->GetFormat(), m_Options));
+}
+
+/* finishLoad replaces the placeholder with immutable storage for the image. It uses direct state access so that the
+ * texture unit bindings of the frame being rendered are left alone. */
+void Texture::finishLoad(const int width, const int height, const int channels, const void* data) {
+    m_Width = width;
+    m_Height = height;
+    m_BPP = channels;
+
+    // The data is already laid out for the chosen format, see TextureLoader::upload
+    PixelFormat format = ChoosePixelFormat(channels, m_Options.GammaCorrection);
+    glTextureParameteriv(m_ReferenceID, GL_TEXTURE_SWIZZLE_RGBA, format.Swizzle);
+    glTextureStorage2D(m_ReferenceID, mipLevelCount(width, height, m_Options), format.InternalFormat, width, height);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTextureSubImage2D(m_ReferenceID, 0, 0, 0, width, height, format.Format, GL_UNSIGNED_BYTE, data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (m_Options.GenerateMipMap) {
+        glGenerateTextureMipmap(m_ReferenceID);
+    }
+
+    m_Loaded = true;
+    m_GPUBytes = estimateBytes(width, height, format.Channels, m_Options);
+}
+
+CubeMap::CubeMap(const std::string filePaths[6], const TextureType type, const TextureOptions& options,
+                 const bool async)
+    : m_Type(type), m_Options(options), m_Loaded(false) {
     X v = texInit(GL_TEXTURE_CUBE_MAP, &m_ReferenceID, type, options);
+    std::copy(filePaths, filePaths + 6, m_FilePaths);
 
-    int width, height, bpp;
-    for (unsigned int i = 0; i < 6; i++) {
-        unsigned char* data = stbi_load(filePaths[i].c_str(), &width, &height, &bpp, STBI_rgb_alpha);
-        if (!data) {
-            spdlog::error("[Texture Error] CubeMap '{}' failed to load", filePaths[i]);
-            stbi_image_free(data);
-            throw "Cannot load texture image";
+    if (async) {
+        for (unsigned int i = 0; i < 6; i++) {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, v.internalFormat, 1, 1, 0, v.externalFormat,
+                         v.dataType, PLACEHOLDER_TEXEL);
         }
+        Unbind();
 
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, v.internalFormat, width, height, 0, v.externalFormat,
-                     v.dataType, data);
-        stbi_image_free(data);
+        TextureLoader::Submit(this, filePaths);
+        return;
     }
+    Unbind();
 
-    if (options.GenerateMipMap) {
-        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    // The faces are decoded in parallel on the loader workers and uploaded together into immutable storage
+    TextureLoader::Submit(this, filePaths);
+    TextureLoader::Wait(this);
+    if (!m_Loaded) {
+        spdlog::error("[Texture Error] CubeMap '{}' failed to load", filePaths[0]);
+        throw "Cannot load texture image";
+    }
+}
+
+CubeMap::CubeMap(const std::string& filePath, const TextureType type, const TextureOptions& options)
+    : m_Type(type), m_Options(options), m_Loaded(true) {
+    KtxFile ktx(filePath);
+    if (ktx.GetFaceCount() != 6) {
+        spdlog::error("[Texture Error] CubeMap '{}' does not hold six faces", filePath);
+        throw "Cannot load texture image";
     }
 
+    texInit(GL_TEXTURE_CUBE_MAP, &m_ReferenceID, type, options);
+    uploadKtx(GL_TEXTURE_CUBE_MAP, ktx, options);
     Unbind();
 }
 
-CubeMap::CubeMap(const unsigned int w, const unsigned int h, const TextureType type, const TextureOptions& options) {
+CubeMap::CubeMap(const unsigned int w, const unsigned int h, const TextureType type, const TextureOptions& options)
+    : m_Type(type), m_Options(options), m_Loaded(true) {
     X v = texInit(GL_TEXTURE_CUBE_MAP, &m_ReferenceID, type, options);
 
     for (unsigned int i = 0; i < 6; i++) {
@@ -143,18 +443,37 @@ CubeMap::CubeMap(const unsigned int w, const unsigned int h, const TextureType t
 
 CubeMap::~CubeMap() {
     spdlog::debug("CubeMap {} destroyed", m_ReferenceID);
+    if (!m_Loaded) {
+        TextureLoader::Cancel(this);
+    }
+    BindingCache::DeleteTexture(m_ReferenceID);
     glDeleteTextures(1, &m_ReferenceID);
 }
 
 void CubeMap::Bind(const unsigned int slot, const bool activate) const {
     if (activate) {
         // Activate the texture in position specified by slot
-        glActiveTexture(GL_TEXTURE0 + slot);
+        BindingCache::BindTextureUnit(slot, GL_TEXTURE_CUBE_MAP, m_ReferenceID);
+    } else {
+        BindingCache::BindTexture(GL_TEXTURE_CUBE_MAP, m_ReferenceID);
     }
-
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_ReferenceID);
 }
 
 void CubeMap::Unbind() const {
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    BindingCache::BindTexture(GL_TEXTURE_CUBE_MAP, 0);
+}
+
+/* finishLoad uploads all six faces at once, the data holds them back to back in face order */
+void CubeMap::finishLoad(const int width, const int height, const int channels, const void* data) {
+    PixelFormat format = ChoosePixelFormat(channels, m_Options.GammaCorrection);
+    glTextureParameteriv(m_ReferenceID, GL_TEXTURE_SWIZZLE_RGBA, format.Swizzle);
+    glTextureStorage2D(m_ReferenceID, mipLevelCount(width, height, m_Options), format.InternalFormat, width, height);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTextureSubImage3D(m_ReferenceID, 0, 0, 0, 0, width, height, 6, format.Format, GL_UNSIGNED_BYTE, data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (m_Options.GenerateMipMap) {
+        glGenerateTextureMipmap(m_ReferenceID);
+    }
+
+    m_Loaded = true;
 }
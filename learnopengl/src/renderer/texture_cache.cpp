@@ -0,0 +1,108 @@
+#include <renderer/texture_cache.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <sstream>
+#include <vector>
+
+TextureCacheInst TextureCache::s_Instance;
+
+/* makeKey combines the canonical path with everything that changes how the file ends up on the GPU */
+std::string TextureCache::makeKey(const std::string& filePath, const TextureType type,
+                                  const TextureOptions& options) {
+    std::error_code error;
+    std::filesystem::path path = std::filesystem::weakly_canonical(filePath, error);
+    if (error) {
+        path = std::filesystem::path(filePath).lexically_normal();
+    }
+
+    std::stringstream ss;
+    ss << path.string() << '|' << (int)type << '|' << (int)options.MinFilter << ',' << (int)options.MagFilter << ','
+       << (int)options.WrapS << ',' << (int)options.WrapT << ',' << (int)options.WrapR << ','
+       << options.GenerateMipMap << options.GammaCorrection << (int)options.Compression << options.Streamed << ','
+       << options.BorderColor.r << ',' << options.BorderColor.g << ',' << options.BorderColor.b << ','
+       << options.BorderColor.a;
+    return ss.str();
+}
+
+std::shared_ptr<Texture> TextureCache::Acquire(const std::string& filePath, const TextureType type,
+                                               const TextureOptions& options, const bool async) {
+    std::string key = makeKey(filePath, type, options);
+
+    std::unordered_map<std::string, std::weak_ptr<Texture>>::iterator it = s_Instance.m_Entries.find(key);
+    if (it != s_Instance.m_Entries.end()) {
+        std::shared_ptr<Texture> texture = it->second.lock();
+        if (texture) {
+            s_Instance.m_Stats.Hits++;
+            return texture;
+        }
+    }
+
+    s_Instance.m_Stats.Misses++;
+    std::shared_ptr<Texture> texture = std::make_shared<Texture>(filePath, type, options, async);
+    s_Instance.m_Entries[key] = texture;
+    return texture;
+}
+
+/* Update evicts textures that were not bound during the last frame, oldest first, until the budget is met. Textures
+ * used in the last frame are kept even above the budget since they would be reloaded right away. */
+void TextureCache::Update() {
+    unsigned long long lastFrame = s_Instance.m_Frame++;
+
+    std::vector<std::shared_ptr<Texture>> resident;
+    size_t residentBytes = 0;
+    for (std::unordered_map<std::string, std::weak_ptr<Texture>>::iterator it = s_Instance.m_Entries.begin();
+         it != s_Instance.m_Entries.end();) {
+        std::shared_ptr<Texture> texture = it->second.lock();
+        if (!texture) {
+            it = s_Instance.m_Entries.erase(it);
+            continue;
+        }
+
+        if (texture->IsResident()) {
+            residentBytes += texture->GetGPUBytes();
+            resident.push_back(std::move(texture));
+        }
+        ++it;
+    }
+
+    if (residentBytes <= s_Instance.m_Budget) {
+        return;
+    }
+
+    std::sort(resident.begin(), resident.end(), [](const std::shared_ptr<Texture>& a, const std::shared_ptr<Texture>& b) {
+        return a->GetLastUsedFrame() < b->GetLastUsedFrame();
+    });
+
+    for (const std::shared_ptr<Texture>& texture : resident) {
+        if (residentBytes <= s_Instance.m_Budget || texture->GetLastUsedFrame() >= lastFrame) {
+            break;
+        }
+
+        spdlog::debug("TextureCache evicting '{}' ({} bytes)", texture->GetFilePath(), texture->GetGPUBytes());
+        residentBytes -= texture->GetGPUBytes();
+        texture->Evict();
+        s_Instance.m_Stats.Evictions++;
+    }
+}
+
+void TextureCache::SetBudget(size_t bytes) {
+    s_Instance.m_Budget = bytes;
+}
+
+size_t TextureCache::GetResidentBytes() {
+    size_t bytes = 0;
+    for (const std::pair<const std::string, std::weak_ptr<Texture>>& entry : s_Instance.m_Entries) {
+        std::shared_ptr<Texture> texture = entry.second.lock();
+        if (texture) {
+            bytes += texture->GetGPUBytes();
+        }
+    }
+
+    return bytes;
+}
+
+void TextureCache::NotifyReload(const Texture& texture) {
+    spdlog::debug("TextureCache reloaded '{}'", texture.GetFilePath());
+    s_Instance.m_Stats.Reloads++;
+}
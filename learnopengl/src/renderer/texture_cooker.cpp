@@ -0,0 +1,229 @@
+#include <renderer/ktx.h>
+#include <renderer/texture_cooker.h>
+#include <stb_image/stb_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+
+float srgbToLinear(const unsigned char value) {
+    float c = value / 255.0f;
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+unsigned char linearToSrgb(const float value) {
+    float c = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    return (unsigned char)std::clamp(std::lround(c * 255.0f), 0L, 255L);
+}
+
+std::string TextureCooker::GetCookedPath(const std::string& srcPath) {
+    return std::filesystem::path(srcPath).replace_extension(".ktx2").string();
+}
+
+bool TextureCooker::loadImage(const std::string& filePath, const bool flip, std::vector<unsigned char>& pixels,
+                              int& width, int& height) {
+    stbi_set_flip_vertically_on_load_thread(flip ? 1 : 0);
+
+    int bpp;
+    unsigned char* data = stbi_load(filePath.c_str(), &width, &height, &bpp, STBI_rgb_alpha);
+    if (!data) {
+        spdlog::error("[Texture Error] Texture '{}' failed to load", filePath);
+        return false;
+    }
+
+    pixels.assign(data, data + (size_t)width * height * 4);
+    stbi_image_free(data);
+    return true;
+}
+
+/* downsample halves an RGBA8 image with a box filter, odd edges reuse their last texel */
+void TextureCooker::downsample(const std::vector<unsigned char>& src, const int width, const int height,
+                               const bool srgb, std::vector<unsigned char>& dst) {
+    int dstWidth = std::max(1, width / 2);
+    int dstHeight = std::max(1, height / 2);
+    dst.resize((size_t)dstWidth * dstHeight * 4);
+
+    for (int y = 0; y < dstHeight; y++) {
+        int y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+        for (int x = 0; x < dstWidth; x++) {
+            int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+            const unsigned char* texels[4] = {
+                &src[((size_t)y0 * width + x0) * 4],
+                &src[((size_t)y0 * width + x1) * 4],
+                &src[((size_t)y1 * width + x0) * 4],
+                &src[((size_t)y1 * width + x1) * 4],
+            };
+
+            unsigned char* out = &dst[((size_t)y * dstWidth + x) * 4];
+            for (int c = 0; c < 4; c++) {
+                // Colour channels of sRGB images are averaged in linear space, alpha is always linear
+                if (srgb && c < 3) {
+                    float sum = 0.0f;
+                    for (const unsigned char* t : texels) {
+                        sum += srgbToLinear(t[c]);
+                    }
+                    out[c] = linearToSrgb(sum * 0.25f);
+                } else {
+                    unsigned int sum = texels[0][c] + texels[1][c] + texels[2][c] + texels[3][c];
+                    out[c] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        }
+    }
+}
+
+bool TextureCooker::Cook(const std::string& srcPath, const std::string& dstPath, const CookOptions& options) {
+    return cookFaces({srcPath}, dstPath, options);
+}
+
+bool TextureCooker::CookCubeMap(const std::string srcPaths[6], const std::string& dstPath,
+                                const CookOptions& options) {
+    CookOptions cubeOptions = options;
+    cubeOptions.Flip = false;
+    return cookFaces(std::vector<std::string>(srcPaths, srcPaths + 6), dstPath, cubeOptions);
+}
+
+/* cookFaces builds the mip chain of every face and stores each level with its faces back to back */
+bool TextureCooker::cookFaces(const std::vector<std::string>& srcPaths, const std::string& dstPath,
+                              const CookOptions& options) {
+    std::vector<std::vector<unsigned char>> faces(srcPaths.size());
+    int width = 0, height = 0;
+    for (size_t i = 0; i < srcPaths.size(); i++) {
+        int w, h;
+        if (!loadImage(srcPaths[i], options.Flip, faces[i], w, h)) {
+            return false;
+        }
+        if (i > 0 && (w != width || h != height)) {
+            spdlog::error("[Texture Error] Face '{}' does not match the size of the other faces", srcPaths[i]);
+            return false;
+        }
+        width = w;
+        height = h;
+    }
+
+    BlockFormat block = chooseBlockFormat(faces, options);
+    // Normal maps hold vectors, not colours
+    bool srgb = options.Srgb && block != BlockFormat::BC5;
+
+    KtxImage image;
+    image.Format = getKtxFormat(block, srgb);
+    image.Width = width;
+    image.Height = height;
+    image.FaceCount = (unsigned int)faces.size();
+    image.Orientation = options.Flip ? "ru" : "rd";
+
+    double psnr = std::numeric_limits<double>::infinity();
+    while (true) {
+        std::vector<unsigned char>& level = image.Levels.emplace_back();
+        for (const std::vector<unsigned char>& face : faces) {
+            if (block == BlockFormat::None) {
+                level.insert(level.end(), face.begin(), face.end());
+                continue;
+            }
+
+            std::vector<unsigned char> blocks = CompressImage(block, face.data(), width, height);
+            if (image.Levels.size() == 1) {
+                // Round-trip the full resolution image to measure the encoding error
+                std::vector<unsigned char> decoded = DecompressImage(block, blocks.data(), width, height);
+                unsigned int channels = block == BlockFormat::BC5 ? 2 : (block == BlockFormat::BC1 ? 3 : 4);
+                psnr = std::min(psnr, ComputePSNR(face.data(), decoded.data(), (size_t)width * height, channels));
+            }
+            level.insert(level.end(), blocks.begin(), blocks.end());
+        }
+
+        if (!options.GenerateMipMap || (width == 1 && height == 1)) {
+            break;
+        }
+
+        for (std::vector<unsigned char>& face : faces) {
+            std::vector<unsigned char> next;
+            downsample(face, width, height, srgb, next);
+            if (options.Compression == CookCompression::NormalMap) {
+                renormalize(next);
+            }
+            face.swap(next);
+        }
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+
+    if (block != BlockFormat::None) {
+        spdlog::info("Encoded '{}' as {} with a PSNR of {:.2f} dB", dstPath, getBlockFormatName(block), psnr);
+        if (psnr < options.MinPSNR) {
+            spdlog::error("[Texture Error] '{}' is below the required PSNR of {:.2f} dB", dstPath, options.MinPSNR);
+            return false;
+        }
+    }
+
+    if (!WriteKtx(dstPath, image)) {
+        return false;
+    }
+
+    spdlog::info("Cooked '{}' ({}x{}, {} levels)", dstPath, image.Width, image.Height, image.Levels.size());
+    return true;
+}
+
+/* chooseBlockFormat picks BC1 for opaque colour images, BC3 when any texel is transparent and BC5 for normal maps */
+BlockFormat TextureCooker::chooseBlockFormat(const std::vector<std::vector<unsigned char>>& faces,
+                                             const CookOptions& options) {
+    switch (options.Compression) {
+        case CookCompression::Color:
+            for (const std::vector<unsigned char>& face : faces) {
+                for (size_t i = 3; i < face.size(); i += 4) {
+                    if (face[i] != 255) {
+                        return BlockFormat::BC3;
+                    }
+                }
+            }
+            return BlockFormat::BC1;
+        case CookCompression::NormalMap:
+            return BlockFormat::BC5;
+        default:
+            return BlockFormat::None;
+    }
+}
+
+KtxFormat TextureCooker::getKtxFormat(const BlockFormat block, const bool srgb) {
+    switch (block) {
+        case BlockFormat::BC1:
+            return srgb ? KtxFormat::BC1_RGB_SRGB : KtxFormat::BC1_RGB;
+        case BlockFormat::BC3:
+            return srgb ? KtxFormat::BC3_SRGB : KtxFormat::BC3;
+        case BlockFormat::BC5:
+            return KtxFormat::BC5;
+        default:
+            return srgb ? KtxFormat::RGBA8_SRGB : KtxFormat::RGBA8;
+    }
+}
+
+const char* TextureCooker::getBlockFormatName(const BlockFormat block) {
+    switch (block) {
+        case BlockFormat::BC1:
+            return "BC1";
+        case BlockFormat::BC3:
+            return "BC3";
+        case BlockFormat::BC5:
+            return "BC5";
+        default:
+            return "RGBA8";
+    }
+}
+
+/* renormalize restores unit length to the normals of a downsampled normal map, averaging shortens them */
+void TextureCooker::renormalize(std::vector<unsigned char>& pixels) {
+    for (size_t i = 0; i < pixels.size(); i += 4) {
+        float n[3];
+        for (int c = 0; c < 3; c++) {
+            n[c] = pixels[i + c] / 255.0f * 2.0f - 1.0f;
+        }
+
+        float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length < 1e-6f) {
+            continue;
+        }
+        for (int c = 0; c < 3; c++) {
+            pixels[i + c] = (unsigned char)std::lround((n[c] / length * 0.5f + 0.5f) * 255.0f);
+        }
+    }
+}
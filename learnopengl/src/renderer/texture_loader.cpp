@@ -0,0 +1,347 @@
+#include <renderer/binding_cache.h>
+#include <renderer/pixel_format.h>
+#include <renderer/texture.h>
+#include <renderer/texture_loader.h>
+#include <stb_image/stb_image.h>
+
+#include <algorithm>
+#include <cstring>
+
+TextureLoaderInst TextureLoader::s_Instance;
+
+TextureLoaderInst::~TextureLoaderInst() {
+    Stop();
+
+    // The GL context is gone at this point, only the CPU side is released
+    for (DecodedImage& image : m_Decoded) {
+        stbi_image_free(image.Pixels);
+    }
+    for (std::pair<const CubeMap* const, PendingCubeMap>& it : m_CubeMaps) {
+        for (DecodedImage& face : it.second.Faces) {
+            stbi_image_free(face.Pixels);
+        }
+    }
+}
+
+void TextureLoaderInst::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Condition.notify_all();
+
+    for (std::thread& worker : m_Workers) {
+        worker.join();
+    }
+    m_Workers.clear();
+}
+
+void TextureLoader::Shutdown() {
+    s_Instance.Stop();
+
+    for (unsigned int& buffer : s_Instance.m_PixelBuffers) {
+        if (buffer) {
+            BindingCache::DeleteBuffer(buffer);
+            glDeleteBuffers(1, &buffer);
+            buffer = 0;
+        }
+    }
+}
+
+/* start spawns the worker pool on first use, leaving one hardware thread to the GL thread */
+void TextureLoader::start() {
+    if (!s_Instance.m_Workers.empty()) {
+        return;
+    }
+
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    unsigned int count = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    for (unsigned int i = 0; i < count; i++) {
+        s_Instance.m_Workers.emplace_back(&TextureLoader::workerLoop);
+    }
+
+    spdlog::debug("TextureLoader started {} worker threads", count);
+}
+
+void TextureLoader::Submit(Texture* texture, const std::string& filePath) {
+    TextureLoadJob job;
+    job.FilePath = filePath;
+    // OpenGL expects image coordinates to start from bottom-left
+    job.Flip = true;
+    job.Srgb = texture->m_Options.GammaCorrection;
+    job.Target2D = texture;
+    submit(std::move(job), texture);
+}
+
+void TextureLoader::Submit(CubeMap* cubeMap, const std::string filePaths[6]) {
+    for (unsigned int i = 0; i < 6; i++) {
+        TextureLoadJob job;
+        job.FilePath = filePaths[i];
+        job.Face = i;
+        // Cube map faces are addressed from the top-left, so they are not flipped
+        job.Flip = false;
+        job.Srgb = cubeMap->m_Options.GammaCorrection;
+        job.TargetCube = cubeMap;
+        submit(std::move(job), cubeMap);
+    }
+}
+
+void TextureLoader::submit(TextureLoadJob job, const void* owner) {
+    start();
+
+    {
+        std::lock_guard<std::mutex> lock(s_Instance.m_Mutex);
+        job.ID = s_Instance.m_NextID++;
+        s_Instance.m_Live[job.ID] = owner;
+        s_Instance.m_Jobs.push_back(std::move(job));
+    }
+    s_Instance.m_Condition.notify_one();
+}
+
+void TextureLoader::Cancel(const void* owner) {
+    std::lock_guard<std::mutex> lock(s_Instance.m_Mutex);
+
+    // Jobs in flight on a worker are dropped when their decode finishes
+    for (std::unordered_map<unsigned long long, const void*>::iterator it = s_Instance.m_Live.begin();
+         it != s_Instance.m_Live.end();) {
+        if (it->second == owner) {
+            it = s_Instance.m_Live.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    std::deque<TextureLoadJob>& jobs = s_Instance.m_Jobs;
+    jobs.erase(std::remove_if(jobs.begin(), jobs.end(),
+                              [owner](const TextureLoadJob& job) {
+                                  return job.Target2D == owner || job.TargetCube == owner;
+                              }),
+               jobs.end());
+
+    std::deque<DecodedImage>& decoded = s_Instance.m_Decoded;
+    for (std::deque<DecodedImage>::iterator it = decoded.begin(); it != decoded.end();) {
+        if (it->Job.Target2D == owner || it->Job.TargetCube == owner) {
+            release(*it);
+            it = decoded.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    std::unordered_map<const CubeMap*, PendingCubeMap>::iterator cube =
+        s_Instance.m_CubeMaps.find((const CubeMap*)owner);
+    if (cube != s_Instance.m_CubeMaps.end()) {
+        for (DecodedImage& face : cube->second.Faces) {
+            release(face);
+        }
+        s_Instance.m_CubeMaps.erase(cube);
+    }
+}
+
+void TextureLoader::workerLoop() {
+    while (true) {
+        TextureLoadJob job;
+        {
+            std::unique_lock<std::mutex> lock(s_Instance.m_Mutex);
+            s_Instance.m_Condition.wait(lock, [] { return s_Instance.m_Stop || !s_Instance.m_Jobs.empty(); });
+            if (s_Instance.m_Stop) {
+                return;
+            }
+
+            job = std::move(s_Instance.m_Jobs.front());
+            s_Instance.m_Jobs.pop_front();
+        }
+
+        DecodedImage image;
+        image.Job = std::move(job);
+        decode(image);
+
+        std::lock_guard<std::mutex> lock(s_Instance.m_Mutex);
+        if (s_Instance.m_Live.find(image.Job.ID) == s_Instance.m_Live.end()) {
+            // Cancelled while decoding
+            release(image);
+            continue;
+        }
+        s_Instance.m_Decoded.push_back(std::move(image));
+    }
+}
+
+/* decode runs on a worker thread, a failed file leaves Pixels null */
+void TextureLoader::decode(DecodedImage& image) {
+    stbi_set_flip_vertically_on_load_thread(image.Job.Flip ? 1 : 0);
+
+    image.Pixels = stbi_load(image.Job.FilePath.c_str(), &image.Width, &image.Height, &image.Channels, 0);
+    if (!image.Pixels) {
+        spdlog::error("[Texture Error] Texture '{}' failed to load", image.Job.FilePath);
+    }
+}
+
+void TextureLoader::Update() {
+    std::deque<DecodedImage> ready;
+    {
+        std::lock_guard<std::mutex> lock(s_Instance.m_Mutex);
+
+        unsigned long long bytes = 0;
+        while (!s_Instance.m_Decoded.empty() && (ready.empty() || bytes < s_Instance.m_UploadBudget)) {
+            DecodedImage& image = s_Instance.m_Decoded.front();
+            bytes += (unsigned long long)image.Width * image.Height * image.Channels;
+            ready.push_back(std::move(image));
+            s_Instance.m_Decoded.pop_front();
+        }
+    }
+
+    if (ready.empty()) {
+        return;
+    }
+
+    for (DecodedImage& image : ready) {
+        {
+            // The owner may have been destroyed since the image was taken out of the queue
+            std::lock_guard<std::mutex> lock(s_Instance.m_Mutex);
+            if (s_Instance.m_Live.erase(image.Job.ID) == 0) {
+                release(image);
+                continue;
+            }
+        }
+
+        if (image.Job.TargetCube) {
+            addFace(image);
+            continue;
+        }
+
+        if (!image.Pixels) {
+            s_Instance.m_Stats.Failed++;
+        } else {
+            upload(&image, 1);
+        }
+        release(image);
+    }
+
+    BindingCache::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+/* addFace stores a decoded cube map face, the faces are uploaded together once all six have arrived */
+void TextureLoader::addFace(DecodedImage& image) {
+    const CubeMap* cubeMap = image.Job.TargetCube;
+    PendingCubeMap& pending = s_Instance.m_CubeMaps[cubeMap];
+    pending.Faces[image.Job.Face] = std::move(image);
+    if (++pending.Decoded < 6) {
+        return;
+    }
+
+    bool complete = true;
+    for (const DecodedImage& face : pending.Faces) {
+        const DecodedImage& first = pending.Faces[0];
+        if (!face.Pixels || face.Width != first.Width || face.Height != first.Height) {
+            complete = false;
+        }
+    }
+
+    if (complete) {
+        upload(pending.Faces, 6);
+    } else {
+        spdlog::error("[Texture Error] CubeMap '{}' faces failed to load or differ in size",
+                      pending.Faces[0].Job.FilePath);
+        s_Instance.m_Stats.Failed++;
+    }
+
+    for (DecodedImage& face : pending.Faces) {
+        release(face);
+    }
+    s_Instance.m_CubeMaps.erase(cubeMap);
+}
+
+/* upload copies the pixels into the next unpack buffer of the ring and lets the texture read from it. Images without
+ * a matching GPU format, or cube map faces with differing channel counts, are expanded while being copied. */
+void TextureLoader::upload(DecodedImage* images, unsigned int count) {
+    int channels = images[0].Channels;
+    for (unsigned int i = 1; i < count; i++) {
+        if (images[i].Channels != channels) {
+            channels = 4;
+        }
+    }
+
+    const TextureLoadJob& job = images[0].Job;
+    int width = images[0].Width, height = images[0].Height;
+    PixelFormat format = ChoosePixelFormat(channels, job.Srgb);
+    size_t texelCount = (size_t)width * height;
+    size_t faceBytes = texelCount * format.Channels;
+    size_t bytes = faceBytes * count;
+
+    unsigned int& buffer = s_Instance.m_PixelBuffers[s_Instance.m_NextPixelBuffer];
+    s_Instance.m_NextPixelBuffer = (s_Instance.m_NextPixelBuffer + 1) % TEXTURE_UPLOAD_BUFFERS;
+    if (!buffer) {
+        glGenBuffers(1, &buffer);
+    }
+
+    BindingCache::BindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+    // Orphan the previous storage so mapping does not wait on an upload that still reads from it
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    unsigned char* dst = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                                          GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!dst) {
+        spdlog::error("[Texture Error] Failed to map pixel unpack buffer");
+        s_Instance.m_Stats.Failed++;
+        return;
+    }
+
+    for (unsigned int i = 0; i < count; i++) {
+        if (format.Channels == images[i].Channels) {
+            std::memcpy(dst + i * faceBytes, images[i].Pixels, faceBytes);
+        } else {
+            ExpandToRGBA(images[i].Pixels, dst + i * faceBytes, texelCount, images[i].Channels);
+        }
+    }
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    // With an unpack buffer bound, the data pointer is an offset into the buffer
+    if (job.Target2D) {
+        job.Target2D->finishLoad(width, height, channels, nullptr);
+    } else {
+        job.TargetCube->finishLoad(width, height, channels, nullptr);
+    }
+
+    s_Instance.m_Stats.Uploaded++;
+    s_Instance.m_Stats.UploadedBytes += bytes;
+}
+
+void TextureLoader::release(DecodedImage& image) {
+    stbi_image_free(image.Pixels);
+    image.Pixels = nullptr;
+}
+
+void TextureLoader::WaitAll() {
+    while (!IsIdle()) {
+        Update();
+        std::this_thread::yield();
+    }
+}
+
+void TextureLoader::Wait(const void* owner) {
+    while (isPending(owner)) {
+        Update();
+        std::this_thread::yield();
+    }
+}
+
+/* isPending tells whether owner has jobs that are not uploaded yet. The faces of a cube map are uploaded in the Update()
+ * that receives the last one, so there is nothing pending once its jobs are gone. */
+bool TextureLoader::isPending(const void* owner) {
+    std::lock_guard<std::mutex> lock(s_Instance.m_Mutex);
+    for (const std::pair<const unsigned long long, const void*>& it : s_Instance.m_Live) {
+        if (it.second == owner) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TextureLoader::SetUploadBudget(unsigned int bytes) {
+    s_Instance.m_UploadBudget = bytes;
+}
+
+bool TextureLoader::IsIdle() {
+    std::lock_guard<std::mutex> lock(s_Instance.m_Mutex);
+    return s_Instance.m_Live.empty();
+}
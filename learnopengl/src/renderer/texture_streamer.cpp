@@ -0,0 +1,303 @@
+#include <renderer/texture.h>
+#include <renderer/texture_streamer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+TextureStreamerInst TextureStreamer::s_Instance;
+
+// Upper bound for the budget bias, more than the level count of any texture
+const unsigned int MAX_STREAMING_BIAS = 32;
+
+TextureStreamerInst::~TextureStreamerInst() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Condition.notify_all();
+
+    if (m_Worker.joinable()) {
+        m_Worker.join();
+    }
+}
+
+/* start spawns the I/O thread on first use, reading levels is bound by the disk so one thread is enough */
+void TextureStreamer::start() {
+    if (s_Instance.m_Worker.joinable()) {
+        return;
+    }
+
+    s_Instance.m_Worker = std::thread(&TextureStreamer::workerLoop);
+    spdlog::debug("TextureStreamer started");
+}
+
+void TextureStreamer::Register(Texture* texture, std::shared_ptr<KtxFile> file, const StreamedFormat& format) {
+    StreamedTexture& entry = s_Instance.m_Textures[texture];
+    entry = StreamedTexture();
+    entry.Target = texture;
+    entry.File = std::move(file);
+    entry.Format = format;
+
+    unsigned int levelCount = entry.File->GetLevelCount();
+    entry.TailLevel = levelCount - 1;
+    for (unsigned int level = 0; level < levelCount; level++) {
+        unsigned int size = std::max(entry.File->GetWidth(), entry.File->GetHeight()) >> level;
+        if (size <= STREAMING_TAIL_SIZE) {
+            entry.TailLevel = level;
+            break;
+        }
+    }
+
+    glTextureParameteri(texture->m_ReferenceID, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+    for (unsigned int level = entry.TailLevel; level < levelCount; level++) {
+        const KtxLevel& data = entry.File->GetLevel(level);
+        if (format.Decode) {
+            unsigned int width = std::max(1u, entry.File->GetWidth() >> level);
+            unsigned int height = std::max(1u, entry.File->GetHeight() >> level);
+            std::vector<unsigned char> rgba = DecompressImage(entry.File->GetFormat().Block, data.Data, width, height);
+            uploadLevel(entry, level, rgba.data(), rgba.size());
+        } else {
+            uploadLevel(entry, level, data.Data, data.Size);
+        }
+    }
+
+    setBaseLevel(entry, entry.TailLevel);
+    entry.RequestedLevel = entry.TailLevel;
+    entry.WantedLevel = entry.TailLevel;
+}
+
+void TextureStreamer::Unregister(const Texture* texture) {
+    // A read in flight finds no entry when it is applied and is dropped
+    s_Instance.m_Textures.erase(texture);
+}
+
+void TextureStreamer::Request(const Texture& texture, float footprint) {
+    std::unordered_map<const Texture*, StreamedTexture>::iterator it = s_Instance.m_Textures.find(&texture);
+    if (it == s_Instance.m_Textures.end()) {
+        return;
+    }
+
+    // Level whose size matches the footprint, rounded to the finer level
+    StreamedTexture& entry = it->second;
+    float size = (float)std::max(entry.File->GetWidth(), entry.File->GetHeight());
+    unsigned int level = 0;
+    if (footprint < size) {
+        level = (unsigned int)std::floor(std::log2(size / std::max(footprint, 1.0f)));
+    }
+    level = std::min(level, entry.TailLevel);
+
+    if (entry.LastRequestFrame != s_Instance.m_Frame) {
+        entry.LastRequestFrame = s_Instance.m_Frame;
+        entry.RequestedLevel = level;
+    } else {
+        entry.RequestedLevel = std::min(entry.RequestedLevel, level);
+    }
+}
+
+float TextureStreamer::ComputeFootprint(const glm::vec3& center, float radius, const glm::vec3& cameraPos, float fovY,
+                                        float viewportHeight) {
+    float distance = glm::length(center - cameraPos);
+    if (distance <= radius) {
+        return std::numeric_limits<float>::max();
+    }
+
+    // Tangent of the angle subtended by the sphere relative to the tangent of half the field of view
+    float sinAngle = radius / distance;
+    float tanAngle = sinAngle / std::sqrt(1.0f - sinAngle * sinAngle);
+    return viewportHeight * tanAngle / std::tan(fovY * 0.5f);
+}
+
+void TextureStreamer::Update() {
+    std::deque<StreamRead> finished;
+    {
+        std::lock_guard<std::mutex> lock(s_Instance.m_Mutex);
+        finished.swap(s_Instance.m_Finished);
+    }
+
+    for (StreamRead& streamRead : finished) {
+        apply(streamRead);
+    }
+
+    // Textures that are no longer requested keep their levels for a few frames, then fall back to the tail
+    for (std::pair<const Texture* const, StreamedTexture>& it : s_Instance.m_Textures) {
+        StreamedTexture& entry = it.second;
+        if (entry.LastRequestFrame == s_Instance.m_Frame) {
+            entry.WantedLevel = entry.RequestedLevel;
+        } else if (s_Instance.m_Frame - entry.LastRequestFrame > STREAMING_GRACE_FRAMES) {
+            entry.WantedLevel = entry.TailLevel;
+        }
+    }
+
+    // Skip the same number of levels on every texture until the wanted levels fit, the tails are always kept
+    unsigned int bias = 0;
+    for (; bias < MAX_STREAMING_BIAS; bias++) {
+        size_t total = 0;
+        for (std::pair<const Texture* const, StreamedTexture>& it : s_Instance.m_Textures) {
+            const StreamedTexture& entry = it.second;
+            total += residentBytes(entry, std::min(entry.WantedLevel + bias, entry.TailLevel));
+        }
+
+        if (total <= s_Instance.m_Budget) {
+            break;
+        }
+    }
+
+    std::vector<StreamRead> reads;
+    s_Instance.m_Stats.ResidentBytes = 0;
+    for (std::pair<const Texture* const, StreamedTexture>& it : s_Instance.m_Textures) {
+        StreamedTexture& entry = it.second;
+        unsigned int level = std::min(entry.WantedLevel + bias, entry.TailLevel);
+
+        if (level > entry.ResidentLevel) {
+            dropLevels(entry, level);
+        } else if (level < entry.ResidentLevel && !entry.PendingRead) {
+            StreamRead streamRead;
+            streamRead.ID = s_Instance.m_NextID++;
+            streamRead.Target = entry.Target;
+            streamRead.File = entry.File;
+            streamRead.Format = entry.Format;
+            streamRead.FirstLevel = level;
+            streamRead.LastLevel = entry.ResidentLevel;
+            entry.PendingRead = streamRead.ID;
+            reads.push_back(std::move(streamRead));
+        }
+
+        s_Instance.m_Stats.ResidentBytes += residentBytes(entry, entry.ResidentLevel);
+    }
+    s_Instance.m_Stats.Bias = bias;
+    s_Instance.m_Frame++;
+
+    if (reads.empty()) {
+        return;
+    }
+
+    start();
+    {
+        std::lock_guard<std::mutex> lock(s_Instance.m_Mutex);
+        for (StreamRead& streamRead : reads) {
+            s_Instance.m_Reads.push_back(std::move(streamRead));
+        }
+    }
+    s_Instance.m_Condition.notify_one();
+}
+
+void TextureStreamer::workerLoop() {
+    while (true) {
+        StreamRead streamRead;
+        {
+            std::unique_lock<std::mutex> lock(s_Instance.m_Mutex);
+            s_Instance.m_Condition.wait(lock, [] { return s_Instance.m_Stop || !s_Instance.m_Reads.empty(); });
+            if (s_Instance.m_Stop) {
+                return;
+            }
+
+            streamRead = std::move(s_Instance.m_Reads.front());
+            s_Instance.m_Reads.pop_front();
+        }
+
+        read(streamRead);
+
+        std::lock_guard<std::mutex> lock(s_Instance.m_Mutex);
+        s_Instance.m_Finished.push_back(std::move(streamRead));
+    }
+}
+
+/* read runs on the I/O thread, copying the levels out of the mapping is what pages them in from disk */
+void TextureStreamer::read(StreamRead& streamRead) {
+    const KtxFile& file = *streamRead.File;
+    for (unsigned int level = streamRead.FirstLevel; level < streamRead.LastLevel; level++) {
+        const KtxLevel& data = file.GetLevel(level);
+        if (streamRead.Format.Decode) {
+            unsigned int width = std::max(1u, file.GetWidth() >> level);
+            unsigned int height = std::max(1u, file.GetHeight() >> level);
+            streamRead.Levels.push_back(DecompressImage(file.GetFormat().Block, data.Data, width, height));
+        } else {
+            streamRead.Levels.emplace_back(data.Data, data.Data + data.Size);
+        }
+    }
+}
+
+/* apply uploads the levels of a finished read and makes them visible by lowering the base level */
+void TextureStreamer::apply(StreamRead& streamRead) {
+    std::unordered_map<const Texture*, StreamedTexture>::iterator it = s_Instance.m_Textures.find(streamRead.Target);
+    if (it == s_Instance.m_Textures.end() || it->second.PendingRead != streamRead.ID) {
+        // Unregistered, or levels were dropped while reading
+        return;
+    }
+
+    StreamedTexture& entry = it->second;
+    entry.PendingRead = 0;
+    for (unsigned int level = streamRead.FirstLevel; level < streamRead.LastLevel; level++) {
+        const std::vector<unsigned char>& data = streamRead.Levels[level - streamRead.FirstLevel];
+        uploadLevel(entry, level, data.data(), data.size());
+    }
+
+    s_Instance.m_Stats.LevelsLoaded += streamRead.LastLevel - streamRead.FirstLevel;
+    setBaseLevel(entry, streamRead.FirstLevel);
+}
+
+/* dropLevels releases every level finer than level. Levels below the base level are not part of the texture's
+ * completeness, so they are redefined as empty images of any format. */
+void TextureStreamer::dropLevels(StreamedTexture& texture, unsigned int level) {
+    // The read would upload levels next to a hole in the chain
+    texture.PendingRead = 0;
+
+    unsigned int first = texture.ResidentLevel;
+    setBaseLevel(texture, level);
+    BindingCache::BindTextureUnit(STREAMING_TEXTURE_UNIT, GL_TEXTURE_2D, texture.Target->m_ReferenceID);
+    for (unsigned int i = first; i < level; i++) {
+        glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+
+    s_Instance.m_Stats.LevelsDropped += level - first;
+}
+
+void TextureStreamer::setBaseLevel(StreamedTexture& texture, unsigned int level) {
+    glTextureParameteri(texture.Target->m_ReferenceID, GL_TEXTURE_BASE_LEVEL, level);
+    texture.ResidentLevel = level;
+    texture.Target->m_GPUBytes = residentBytes(texture, level);
+}
+
+/* uploadLevel defines one level of the texture, the streamed texture is mutable so levels can come and go */
+void TextureStreamer::uploadLevel(const StreamedTexture& texture, unsigned int level, const unsigned char* data,
+                                  size_t size) {
+    unsigned int width = std::max(1u, texture.File->GetWidth() >> level);
+    unsigned int height = std::max(1u, texture.File->GetHeight() >> level);
+
+    BindingCache::BindTextureUnit(STREAMING_TEXTURE_UNIT, GL_TEXTURE_2D, texture.Target->m_ReferenceID);
+    if (texture.Format.Decode) {
+        glTexImage2D(GL_TEXTURE_2D, level, texture.Format.InternalFormat, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                     data);
+    } else if (texture.Format.Compressed) {
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, texture.Format.InternalFormat, width, height, 0, (GLsizei)size,
+                               data);
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, level, texture.Format.InternalFormat, width, height, 0, texture.Format.Format,
+                     texture.Format.Type, data);
+    }
+}
+
+size_t TextureStreamer::levelBytes(const StreamedTexture& texture, unsigned int level) {
+    unsigned int width = std::max(1u, texture.File->GetWidth() >> level);
+    unsigned int height = std::max(1u, texture.File->GetHeight() >> level);
+    if (texture.Format.Decode) {
+        return (size_t)width * height * 4;
+    }
+
+    return KtxImageSize(texture.File->GetFormat(), width, height);
+}
+
+/* residentBytes is the GPU memory of the chain from level down to the smallest level */
+size_t TextureStreamer::residentBytes(const StreamedTexture& texture, unsigned int level) {
+    size_t bytes = 0;
+    for (unsigned int i = level; i < texture.File->GetLevelCount(); i++) {
+        bytes += levelBytes(texture, i);
+    }
+
+    return bytes;
+}
+
+void TextureStreamer::SetBudget(size_t bytes) {
+    s_Instance.m_Budget = bytes;
+}
@@ -1,22 +1,24 @@
 #include <common.h>
+#include <renderer/binding_cache.h>
 #include <renderer/ubo.h>
 
 UniformBuffer::UniformBuffer(unsigned int size) {
     glGenBuffers(1, &m_ReferenceID);
     Bind();
-    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STATIC_DRAW);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
 }
 
 UniformBuffer::~UniformBuffer() {
+    BindingCache::DeleteBuffer(m_ReferenceID);
     glDeleteBuffers(1, &m_ReferenceID);
 }
 
 void UniformBuffer::Bind() const {
-    glBindBuffer(GL_UNIFORM_BUFFER, m_ReferenceID);
+    BindingCache::BindBuffer(GL_UNIFORM_BUFFER, m_ReferenceID);
 }
 
 void UniformBuffer::Unbind() const {
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    BindingCache::BindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
 void UniformBuffer::BindRange(unsigned int offset, unsigned int size, unsigned int binding) const {
@@ -24,8 +26,11 @@ void UniformBuffer::BindRange(unsigned int offset, unsigned int size, unsigned i
     // unsigned int uniformBlockIndex = glGetUniformBlockIndex(shader.GetReferenceID(), "ExampleBlock");
     // glUniformBlockBinding(shader.GetReferenceID(), uniformBlockIndex, binding);
     glBindBufferRange(GL_UNIFORM_BUFFER, binding, m_ReferenceID, offset, size);
+    // Binding a range also binds the buffer to the generic uniform buffer target
+    BindingCache::TrackBuffer(GL_UNIFORM_BUFFER, m_ReferenceID);
 }
 
 void UniformBuffer::InsertData(unsigned int offset, const void* data, unsigned int size) const {
+    Bind();
     glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
 }
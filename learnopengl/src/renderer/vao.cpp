@@ -1,13 +1,15 @@
 #include <common.h>
+#include <renderer/binding_cache.h>
 #include <renderer/vao.h>
 
 VertexArray::VertexArray() : m_ReferenceID(0), m_CurrCount(0) {
     glGenVertexArrays(1, &m_ReferenceID);
-    glBindVertexArray(m_ReferenceID);
+    Bind();
 }
 
 VertexArray::~VertexArray() {
     spdlog::debug("VertexArray {} destroyed", m_ReferenceID);
+    BindingCache::DeleteVertexArray(m_ReferenceID);
     glDeleteVertexArrays(1, &m_ReferenceID);
 }
 
@@ -36,9 +38,9 @@ void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& la
 }
 
 void VertexArray::Bind() const {
-    glBindVertexArray(m_ReferenceID);
+    BindingCache::BindVertexArray(m_ReferenceID);
 }
 
 void VertexArray::Unbind() const {
-    glBindVertexArray(0);
+    BindingCache::BindVertexArray(0);
 }
\ No newline at end of file
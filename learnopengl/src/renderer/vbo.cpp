@@ -1,4 +1,5 @@
 #include <common.h>
+#include <renderer/binding_cache.h>
 #include <renderer/vbo.h>
 
 VertexBuffer::VertexBuffer(const void* data, unsigned int size) : m_ReferenceID(0) {
@@ -7,15 +8,27 @@ VertexBuffer::VertexBuffer(const void* data, unsigned int size) : m_ReferenceID(
     glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
 }
 
+/* VertexBuffer allocates immutable storage of the given size that can only be filled through InsertData */
+VertexBuffer::VertexBuffer(unsigned int size) : m_ReferenceID(0) {
+    glGenBuffers(1, &m_ReferenceID);
+    Bind();
+    glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+}
+
 VertexBuffer::~VertexBuffer() {
     spdlog::debug("VertexBuffer {} destroyed", m_ReferenceID);
+    BindingCache::DeleteBuffer(m_ReferenceID);
     glDeleteBuffers(1, &m_ReferenceID);
 }
 
 void VertexBuffer::Bind() const {
-    glBindBuffer(GL_ARRAY_BUFFER, m_ReferenceID);
+    BindingCache::BindBuffer(GL_ARRAY_BUFFER, m_ReferenceID);
 }
 
 void VertexBuffer::Unbind() const {
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    BindingCache::BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void VertexBuffer::InsertData(unsigned int offset, const void* data, unsigned int size) const {
+    glNamedBufferSubData(m_ReferenceID, offset, size, data);
 }
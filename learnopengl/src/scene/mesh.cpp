@@ -1,18 +1,88 @@
 #include <scene/mesh.h>
+#include <scene/vertex_packing.h>
 
-Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices,
+Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
            std::vector<std::shared_ptr<Texture>> textures)
-    : m_Vertices(vertices), m_Indices(indices), m_Textures(textures) {
-    m_VBO = std::make_shared<VertexBuffer>(&vertices[0], (unsigned int)(vertices.size() * sizeof(Vertex)));
-    m_IBO = std::make_shared<IndexBuffer>(&indices[0], (unsigned int)indices.size());
+    : m_OwnsGeometry(true), m_Textures(textures) {
+    std::vector<PackedVertex> packed(vertices.size());
+    PackVertices(vertices.data(), vertices.size(), packed.data());
+    m_Geometry = GetArena().Allocate(packed.data(), (unsigned int)packed.size(), indices.data(),
+                                     (unsigned int)indices.size());
+}
+
+Mesh::Mesh(const GeometryRange& geometry, std::vector<std::shared_ptr<Texture>> textures,
+           std::vector<GeometryRange> lods, std::vector<Meshlet> meshlets)
+    : m_Geometry(geometry), m_Lods(lods), m_Meshlets(meshlets), m_OwnsGeometry(false), m_Textures(textures) {}
+
+Mesh::~Mesh() {
+    // Release the VAO before the arena page it references can go away
+    m_VAO.reset();
+    if (m_OwnsGeometry) {
+        GetArena().Free(m_Geometry);
+    }
+}
+
+void Mesh::CullMeshlets(const Frustum& frustum, const glm::vec3& cameraPosition,
+                        std::vector<GeometryRange>& visible) const {
+    if (m_Meshlets.empty()) {
+        visible.push_back(m_Geometry);
+        return;
+    }
 
-    VertexBufferLayout layout;
-    layout.Push<float>(3);
-    layout.Push<float>(3);
-    layout.Push<float>(2);
+    // Meshlets are consecutive, so a survivor directly after the previous one extends its range
+    size_t first = visible.size();
+    for (const Meshlet& meshlet : m_Meshlets) {
+        if (!IsMeshletVisible(meshlet, frustum, cameraPosition)) {
+            continue;
+        }
 
-    m_VAO = std::make_shared<VertexArray>();
-    m_VAO->AddBuffer(*m_VBO, layout);
+        unsigned int firstIndex = m_Geometry.FirstIndex + meshlet.FirstIndex;
+        if (visible.size() > first && visible.back().FirstIndex + visible.back().IndexCount == firstIndex) {
+            visible.back().IndexCount += meshlet.IndexCount;
+        } else {
+            GeometryRange range = m_Geometry;
+            range.FirstIndex = firstIndex;
+            range.IndexCount = meshlet.IndexCount;
+            visible.push_back(range);
+        }
+    }
+}
+
+/* GetArena returns the arena shared by all meshes, holding vertices in the PackedVertex format */
+GeometryArena& Mesh::GetArena() {
+    static GeometryArena arena = []() {
+        VertexBufferLayout layout;
+        layout.Push(GL_HALF_FLOAT, 4);
+        layout.Push(GL_SHORT, 2, true);
+        layout.Push(GL_HALF_FLOAT, 2);
+        return GeometryArena(layout);
+    }();
+
+    return arena;
+}
+
+// Sampler names of the first few textures of each type, so binding a material does not build strings
+const unsigned int MAX_NAMED_TEXTURES = 4;
+const UniformName TEXTURE_DIFFUSE_NAMES[MAX_NAMED_TEXTURES] = {
+    "u_TextureDiffuse1"_uniform, "u_TextureDiffuse2"_uniform, "u_TextureDiffuse3"_uniform, "u_TextureDiffuse4"_uniform};
+const UniformName TEXTURE_SPECULAR_NAMES[MAX_NAMED_TEXTURES] = {
+    "u_TextureSpecular1"_uniform, "u_TextureSpecular2"_uniform, "u_TextureSpecular3"_uniform,
+    "u_TextureSpecular4"_uniform};
+const UniformName TEXTURE_NORMAL_NAMES[MAX_NAMED_TEXTURES] = {
+    "u_TextureNormal1"_uniform, "u_TextureNormal2"_uniform, "u_TextureNormal3"_uniform, "u_TextureNormal4"_uniform};
+const UniformName TEXTURE_HEIGHT_NAMES[MAX_NAMED_TEXTURES] = {
+    "u_TextureHeight1"_uniform, "u_TextureHeight2"_uniform, "u_TextureHeight3"_uniform, "u_TextureHeight4"_uniform};
+const UniformName TEXTURE_OTHER_NAMES[MAX_NAMED_TEXTURES] = {"u_Texture1"_uniform, "u_Texture2"_uniform,
+                                                             "u_Texture3"_uniform, "u_Texture4"_uniform};
+
+/* setTextureUniform sets the sampler of the nr-th (1-based) texture of a type */
+static void setTextureUniform(Shader& shader, const UniformName* names, const char* prefix, unsigned int nr,
+                              int slot) {
+    if (nr <= MAX_NAMED_TEXTURES) {
+        shader.SetUniform1i(names[nr - 1], slot);
+    } else {
+        shader.SetUniform1i(std::string(prefix) + std::to_string(nr), slot);
+    }
 }
 
 void Mesh::SetupDraw(Shader& shader) const {
@@ -24,30 +94,36 @@ void Mesh::SetupDraw(Shader& shader) const {
 
     shader.Bind();
     for (unsigned int i = 0; i < m_Textures.size(); i++) {
-        std::string name;
+        m_Textures[i]->Bind(i);
         switch (m_Textures[i]->GetType()) {
             case TextureType::Diffuse:
-                name = "u_TextureDiffuse" + std::to_string(diffuseNr++);
+                setTextureUniform(shader, TEXTURE_DIFFUSE_NAMES, "u_TextureDiffuse", diffuseNr++, i);
                 break;
             case TextureType::Specular:
-                name = "u_TextureSpecular" + std::to_string(specularNr++);
+                setTextureUniform(shader, TEXTURE_SPECULAR_NAMES, "u_TextureSpecular", specularNr++, i);
                 break;
             case TextureType::Normal:
-                name = "u_TextureNormal" + std::to_string(normalNr++);
+                setTextureUniform(shader, TEXTURE_NORMAL_NAMES, "u_TextureNormal", normalNr++, i);
                 break;
             case TextureType::Height:
-                name = "u_TextureHeight" + std::to_string(heightNr++);
+                setTextureUniform(shader, TEXTURE_HEIGHT_NAMES, "u_TextureHeight", heightNr++, i);
                 break;
             default:
-                name = "u_Texture" + std::to_string(otherNr++);
+                setTextureUniform(shader, TEXTURE_OTHER_NAMES, "u_Texture", otherNr++, i);
                 break;
         }
-
-        m_Textures[i]->Bind(i);
-        shader.SetUniform1i(name, i);
     }
 }
 
 void Mesh::AddInstancedBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout) const {
+    // The page VAO is shared with other meshes, instanced attributes go into a private one
+    if (!m_VAO) {
+        m_VAO = GetArena().CreateVertexArray(*m_Geometry.Page);
+    }
     m_VAO->AddBuffer(vb, layout, true);
 }
+
+/* SetVertexArray makes the mesh draw through the given VAO, which must be set up over the mesh's arena page */
+void Mesh::SetVertexArray(const std::shared_ptr<VertexArray>& vao) const {
+    m_VAO = vao;
+}
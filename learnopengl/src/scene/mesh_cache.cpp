@@ -0,0 +1,287 @@
+#include <common.h>
+#include <scene/mesh_cache.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+const char MESH_CACHE_MAGIC[8] = {'L', 'G', 'L', 'M', 'E', 'S', 'H', '\0'};
+// Streams start on a 16 byte boundary of the (page aligned) mapping
+const size_t MESH_CACHE_ALIGNMENT = 16;
+
+struct MeshCacheHeader {
+    char Magic[8];
+    uint32_t Version;
+    uint32_t VertexSize;
+    // Size, modification time and content hash of the source model when the cache was written
+    uint64_t SourceSize;
+    int64_t SourceTime;
+    uint64_t SourceHash;
+    uint32_t VertexCount;
+    uint32_t IndexCount;
+    uint32_t MeshCount;
+    float BoundingRadius;
+    uint64_t VertexOffset;
+    uint64_t IndexOffset;
+};
+static_assert(sizeof(MeshCacheHeader) == 72, "Mesh cache header must be 72 bytes");
+
+struct MeshCacheEntry {
+    uint32_t BaseVertex;
+    uint32_t VertexCount;
+    uint32_t FirstIndex;
+    uint32_t IndexCount;
+    // Followed by TextureCount (type, path length, path) records, LodCount MeshLodEntry records and MeshletCount
+    // Meshlet records
+    uint32_t TextureCount;
+    uint32_t LodCount;
+    uint32_t MeshletCount;
+};
+
+struct MeshLodEntry {
+    uint32_t FirstIndex;
+    uint32_t IndexCount;
+    float Error;
+};
+
+/* hashFile is a 64-bit FNV-1a hash of the file content, 0 if the file cannot be read */
+uint64_t hashFile(const std::string& filePath) {
+    MappedFile file(filePath);
+    if (!file.IsValid()) {
+        return 0;
+    }
+
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < file.GetSize(); i++) {
+        hash = (hash ^ file.GetData()[i]) * 1099511628211ull;
+    }
+
+    return hash;
+}
+
+int64_t sourceTime(const std::string& filePath) {
+    std::error_code error;
+    return (int64_t)std::filesystem::last_write_time(filePath, error).time_since_epoch().count();
+}
+
+uint64_t sourceSize(const std::string& filePath) {
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(filePath, error);
+    return error ? 0 : (uint64_t)size;
+}
+
+std::string GetMeshCachePath(const std::string& sourcePath) {
+    return sourcePath + ".meshcache";
+}
+
+MeshCacheFile::MeshCacheFile(const std::string& filePath, const std::string& sourcePath)
+    : m_File(filePath),
+      m_FilePath(filePath),
+      m_Valid(false),
+      m_RefreshTime(0),
+      m_Vertices(nullptr),
+      m_Indices(nullptr),
+      m_VertexCount(0),
+      m_IndexCount(0),
+      m_BoundingRadius(0.0f) {
+    if (m_File.IsValid()) {
+        m_Valid = parse(filePath, sourcePath);
+    }
+}
+
+/* The header of a cache whose source was only touched gets the new modification time, so the next load does not hash
+ * the source again. The mapping is read-only, so the header is written after closing it. */
+MeshCacheFile::~MeshCacheFile() {
+    if (!m_Valid || m_RefreshTime == 0) {
+        return;
+    }
+    m_File.Close();
+
+    std::fstream stream(m_FilePath, std::ios::binary | std::ios::in | std::ios::out);
+    stream.seekp(offsetof(MeshCacheHeader, SourceTime));
+    stream.write((const char*)&m_RefreshTime, sizeof(m_RefreshTime));
+    if (!stream) {
+        spdlog::warn("Cannot update the source time of mesh cache '{}'", m_FilePath);
+    }
+}
+
+/* parse checks the cache against the source, a changed modification time alone only costs a hash of the source
+ * once (e.g. after a checkout) */
+bool MeshCacheFile::parse(const std::string& filePath, const std::string& sourcePath) {
+    const unsigned char* data = m_File.GetData();
+    size_t size = m_File.GetSize();
+
+    MeshCacheHeader header;
+    if (size < sizeof(header)) {
+        spdlog::warn("Mesh cache '{}' is truncated, importing the model again", filePath);
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    if (std::memcmp(header.Magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) != 0 ||
+        header.Version != MESH_CACHE_VERSION || header.VertexSize != sizeof(PackedVertex)) {
+        spdlog::info("Mesh cache '{}' is from another version, importing the model again", filePath);
+        return false;
+    }
+
+    int64_t time = sourceTime(sourcePath);
+    if (header.SourceSize != sourceSize(sourcePath) ||
+        (header.SourceTime != time && header.SourceHash != hashFile(sourcePath))) {
+        spdlog::info("Mesh cache '{}' is older than its model, importing the model again", filePath);
+        return false;
+    }
+    // Same content under a new modification time
+    int64_t refreshTime = header.SourceTime != time ? time : 0;
+
+    size_t offset = sizeof(header);
+    for (unsigned int i = 0; i < header.MeshCount; i++) {
+        MeshCacheEntry entry;
+        if (offset + sizeof(entry) > size) {
+            spdlog::warn("Mesh cache '{}' is truncated, importing the model again", filePath);
+            return false;
+        }
+        std::memcpy(&entry, data + offset, sizeof(entry));
+        offset += sizeof(entry);
+
+        CachedMesh mesh;
+        mesh.BaseVertex = entry.BaseVertex;
+        mesh.VertexCount = entry.VertexCount;
+        mesh.FirstIndex = entry.FirstIndex;
+        mesh.IndexCount = entry.IndexCount;
+        if ((uint64_t)mesh.BaseVertex + mesh.VertexCount > header.VertexCount ||
+            (uint64_t)mesh.FirstIndex + mesh.IndexCount > header.IndexCount) {
+            spdlog::warn("Mesh cache '{}' has an invalid mesh {}, importing the model again", filePath, i);
+            return false;
+        }
+
+        for (unsigned int t = 0; t < entry.TextureCount; t++) {
+            uint32_t record[2];
+            if (offset + sizeof(record) > size) {
+                spdlog::warn("Mesh cache '{}' is truncated, importing the model again", filePath);
+                return false;
+            }
+            std::memcpy(record, data + offset, sizeof(record));
+            offset += sizeof(record);
+
+            if (offset + record[1] > size) {
+                spdlog::warn("Mesh cache '{}' is truncated, importing the model again", filePath);
+                return false;
+            }
+            mesh.Textures.push_back({(TextureType)record[0], std::string((const char*)data + offset, record[1])});
+            offset += record[1];
+        }
+
+        for (unsigned int l = 0; l < entry.LodCount; l++) {
+            MeshLodEntry lod;
+            if (offset + sizeof(lod) > size) {
+                spdlog::warn("Mesh cache '{}' is truncated, importing the model again", filePath);
+                return false;
+            }
+            std::memcpy(&lod, data + offset, sizeof(lod));
+            offset += sizeof(lod);
+
+            if ((uint64_t)lod.FirstIndex + lod.IndexCount > header.IndexCount) {
+                spdlog::warn("Mesh cache '{}' has an invalid mesh {}, importing the model again", filePath, i);
+                return false;
+            }
+            mesh.Lods.push_back({lod.FirstIndex, lod.IndexCount, lod.Error});
+        }
+
+        if (offset + (uint64_t)entry.MeshletCount * sizeof(Meshlet) > size) {
+            spdlog::warn("Mesh cache '{}' is truncated, importing the model again", filePath);
+            return false;
+        }
+        mesh.Meshlets.resize(entry.MeshletCount);
+        std::memcpy(mesh.Meshlets.data(), data + offset, entry.MeshletCount * sizeof(Meshlet));
+        offset += entry.MeshletCount * sizeof(Meshlet);
+        for (const Meshlet& meshlet : mesh.Meshlets) {
+            if ((uint64_t)meshlet.FirstIndex + meshlet.IndexCount > mesh.IndexCount) {
+                spdlog::warn("Mesh cache '{}' has an invalid mesh {}, importing the model again", filePath, i);
+                return false;
+            }
+        }
+
+        m_Meshes.push_back(std::move(mesh));
+    }
+
+    if (header.VertexOffset % MESH_CACHE_ALIGNMENT != 0 || header.IndexOffset % MESH_CACHE_ALIGNMENT != 0 ||
+        header.VertexOffset + (uint64_t)header.VertexCount * sizeof(PackedVertex) > size ||
+        header.IndexOffset + (uint64_t)header.IndexCount * sizeof(unsigned int) > size) {
+        spdlog::warn("Mesh cache '{}' is truncated, importing the model again", filePath);
+        return false;
+    }
+
+    m_Vertices = (const PackedVertex*)(data + header.VertexOffset);
+    m_Indices = (const unsigned int*)(data + header.IndexOffset);
+    m_VertexCount = header.VertexCount;
+    m_IndexCount = header.IndexCount;
+    m_BoundingRadius = header.BoundingRadius;
+    m_RefreshTime = refreshTime;
+    return true;
+}
+
+/* WriteMeshCache stores the header and the mesh table followed by the packed vertex and index streams as they are laid
+ * out in memory */
+bool WriteMeshCache(const std::string& filePath, const std::string& sourcePath, const MeshCacheData& data) {
+    std::vector<unsigned char> table;
+    for (const CachedMesh& mesh : data.Meshes) {
+        MeshCacheEntry entry = {mesh.BaseVertex, mesh.VertexCount, mesh.FirstIndex, mesh.IndexCount,
+                                (uint32_t)mesh.Textures.size(), (uint32_t)mesh.Lods.size(),
+                                (uint32_t)mesh.Meshlets.size()};
+        const unsigned char* bytes = (const unsigned char*)&entry;
+        table.insert(table.end(), bytes, bytes + sizeof(entry));
+
+        for (const MeshTexture& texture : mesh.Textures) {
+            uint32_t record[2] = {(uint32_t)texture.Type, (uint32_t)texture.Path.size()};
+            bytes = (const unsigned char*)record;
+            table.insert(table.end(), bytes, bytes + sizeof(record));
+            table.insert(table.end(), texture.Path.begin(), texture.Path.end());
+        }
+
+        for (const MeshLod& lod : mesh.Lods) {
+            MeshLodEntry lodEntry = {lod.FirstIndex, lod.IndexCount, lod.Error};
+            bytes = (const unsigned char*)&lodEntry;
+            table.insert(table.end(), bytes, bytes + sizeof(lodEntry));
+        }
+
+        bytes = (const unsigned char*)mesh.Meshlets.data();
+        table.insert(table.end(), bytes, bytes + mesh.Meshlets.size() * sizeof(Meshlet));
+    }
+
+    MeshCacheHeader header = {};
+    std::memcpy(header.Magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+    header.Version = MESH_CACHE_VERSION;
+    header.VertexSize = sizeof(PackedVertex);
+    header.SourceSize = sourceSize(sourcePath);
+    header.SourceTime = sourceTime(sourcePath);
+    header.SourceHash = hashFile(sourcePath);
+    header.VertexCount = (uint32_t)data.PackedVertices.size();
+    header.IndexCount = (uint32_t)data.Indices.size();
+    header.MeshCount = (uint32_t)data.Meshes.size();
+    header.BoundingRadius = data.BoundingRadius;
+
+    size_t vertexBytes = data.PackedVertices.size() * sizeof(PackedVertex);
+    size_t indexBytes = data.Indices.size() * sizeof(unsigned int);
+    header.VertexOffset = (sizeof(header) + table.size() + MESH_CACHE_ALIGNMENT - 1) / MESH_CACHE_ALIGNMENT *
+                          MESH_CACHE_ALIGNMENT;
+    header.IndexOffset =
+        (header.VertexOffset + vertexBytes + MESH_CACHE_ALIGNMENT - 1) / MESH_CACHE_ALIGNMENT * MESH_CACHE_ALIGNMENT;
+
+    std::ofstream stream(filePath, std::ios::binary | std::ios::trunc);
+    if (!stream) {
+        spdlog::warn("Cannot write mesh cache '{}'", filePath);
+        return false;
+    }
+
+    const char padding[MESH_CACHE_ALIGNMENT] = {};
+    stream.write((const char*)&header, sizeof(header));
+    stream.write((const char*)table.data(), table.size());
+    stream.write(padding, header.VertexOffset - sizeof(header) - table.size());
+    stream.write((const char*)data.PackedVertices.data(), vertexBytes);
+    stream.write(padding, header.IndexOffset - header.VertexOffset - vertexBytes);
+    stream.write((const char*)data.Indices.data(), indexBytes);
+
+    return (bool)stream;
+}
@@ -0,0 +1,329 @@
+#include <scene/mesh_optimizer.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+const unsigned int INVALID_VERTEX = std::numeric_limits<unsigned int>::max();
+
+/* VertexCache simulates a FIFO post-transform cache with timestamps: a vertex is cached while fewer than
+ * VERTEX_CACHE_SIZE misses happened since it was transformed */
+struct VertexCache {
+    std::vector<unsigned int> Timestamps;
+    unsigned int Time = VERTEX_CACHE_SIZE + 1;
+
+    VertexCache(const unsigned int vertexCount) : Timestamps(vertexCount, 0) {}
+
+    inline bool Contains(const unsigned int vertex) const {
+        return Time - Timestamps[vertex] <= VERTEX_CACHE_SIZE;
+    }
+
+    // Returns 1 if the vertex had to be transformed
+    inline unsigned int Access(const unsigned int vertex) {
+        if (Contains(vertex)) {
+            return 0;
+        }
+        Timestamps[vertex] = Time++;
+        return 1;
+    }
+
+    inline void Flush() {
+        Time += VERTEX_CACHE_SIZE + 1;
+    }
+};
+
+const size_t VERTEX_FLOATS = sizeof(Vertex) / sizeof(float);
+static_assert(sizeof(Vertex) == VERTEX_FLOATS * sizeof(float), "Vertex must only hold floats");
+
+using VertexKey = std::array<uint32_t, VERTEX_FLOATS>;
+
+struct VertexKeyHash {
+    size_t operator()(const VertexKey& key) const {
+        // FNV-1a over the attribute words
+        uint64_t hash = 14695981039346656037ull;
+        for (uint32_t word : key) {
+            hash = (hash ^ word) * 1099511628211ull;
+        }
+        return (size_t)hash;
+    }
+};
+
+/* makeVertexKey returns the bit patterns of the attributes, or of the attributes in units of epsilon */
+VertexKey makeVertexKey(const Vertex& vertex, const float epsilon) {
+    float attributes[VERTEX_FLOATS];
+    std::memcpy(attributes, &vertex, sizeof(Vertex));
+
+    VertexKey key;
+    for (size_t i = 0; i < VERTEX_FLOATS; i++) {
+        if (epsilon > 0.0f) {
+            key[i] = (uint32_t)(int32_t)std::lround(attributes[i] / epsilon);
+        } else {
+            // Adding zero turns -0 into +0 so that both compare equal
+            float value = attributes[i] + 0.0f;
+            std::memcpy(&key[i], &value, sizeof(float));
+        }
+    }
+
+    return key;
+}
+
+VertexCacheStats AnalyzeVertexCache(const unsigned int* indices, const size_t indexCount,
+                                    const unsigned int vertexCount) {
+    VertexCacheStats stats;
+    VertexCache cache(vertexCount);
+    std::vector<bool> referenced(vertexCount, false);
+    unsigned int uniqueCount = 0;
+
+    for (size_t i = 0; i < indexCount; i++) {
+        stats.Transformed += cache.Access(indices[i]);
+        if (!referenced[indices[i]]) {
+            referenced[indices[i]] = true;
+            uniqueCount++;
+        }
+    }
+
+    size_t triangleCount = indexCount / 3;
+    stats.ACMR = triangleCount ? (float)stats.Transformed / (float)triangleCount : 0.0f;
+    stats.ATVR = uniqueCount ? (float)stats.Transformed / (float)uniqueCount : 0.0f;
+    return stats;
+}
+
+unsigned int WeldVertices(Vertex* vertices, const unsigned int vertexCount, unsigned int* indices,
+                          const size_t indexCount, const float epsilon) {
+    std::unordered_map<VertexKey, unsigned int, VertexKeyHash> unique;
+    unique.reserve(vertexCount);
+    std::vector<unsigned int> remap(vertexCount, INVALID_VERTEX);
+    std::vector<Vertex> welded;
+    welded.reserve(vertexCount);
+
+    // Only vertices reached through the indices are kept
+    for (size_t i = 0; i < indexCount; i++) {
+        unsigned int vertex = indices[i];
+        if (remap[vertex] == INVALID_VERTEX) {
+            std::pair<std::unordered_map<VertexKey, unsigned int, VertexKeyHash>::iterator, bool> it =
+                unique.emplace(makeVertexKey(vertices[vertex], epsilon), (unsigned int)welded.size());
+            if (it.second) {
+                welded.push_back(vertices[vertex]);
+            }
+            remap[vertex] = it.first->second;
+        }
+        indices[i] = remap[vertex];
+    }
+
+    std::copy(welded.begin(), welded.end(), vertices);
+    return (unsigned int)welded.size();
+}
+
+/* OptimizeVertexCache fans around one vertex at a time, emitting all its remaining triangles, and picks the next fan
+ * among the vertices just emitted that will still be cached after their own remaining triangles. Without such a
+ * vertex it backtracks through recently emitted vertices, and only when those are exhausted jumps to the next vertex
+ * in input order, which starts a new cluster (Sander et al. 2007, "Fast Triangle Reordering for Vertex Locality and
+ * Reduced Overdraw"). */
+void OptimizeVertexCache(unsigned int* indices, const size_t indexCount, const unsigned int vertexCount,
+                         std::vector<unsigned int>& clusters) {
+    size_t triangleCount = indexCount / 3;
+    clusters.clear();
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // Triangles adjacent to each vertex, stored back to back with per vertex offsets
+    std::vector<unsigned int> live(vertexCount, 0);
+    for (size_t i = 0; i < indexCount; i++) {
+        live[indices[i]]++;
+    }
+
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    std::partial_sum(live.begin(), live.end(), offsets.begin() + 1);
+    std::vector<unsigned int> adjacency(indexCount);
+    std::vector<unsigned int> cursors(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indexCount; i++) {
+        adjacency[cursors[indices[i]]++] = (unsigned int)(i / 3);
+    }
+
+    VertexCache cache(vertexCount);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> deadEnd;
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> output;
+    output.reserve(indexCount);
+    deadEnd.reserve(indexCount);
+
+    unsigned int inputCursor = 0;
+    unsigned int fan = indices[0];
+    clusters.push_back(0);
+
+    while (fan != INVALID_VERTEX) {
+        candidates.clear();
+        for (unsigned int a = offsets[fan]; a < offsets[fan + 1]; a++) {
+            unsigned int triangle = adjacency[a];
+            if (emitted[triangle]) {
+                continue;
+            }
+
+            for (unsigned int c = 0; c < 3; c++) {
+                unsigned int vertex = indices[triangle * 3 + c];
+                output.push_back(vertex);
+                deadEnd.push_back(vertex);
+                candidates.push_back(vertex);
+                live[vertex]--;
+                cache.Access(vertex);
+            }
+            emitted[triangle] = true;
+        }
+
+        // Prefer the candidate that has been in the cache the longest, as long as its fan still fits. A candidate
+        // whose fan does not fit has priority 0 and still beats the dead-end stack.
+        unsigned int next = INVALID_VERTEX;
+        int bestPriority = -1;
+        for (unsigned int vertex : candidates) {
+            if (live[vertex] == 0) {
+                continue;
+            }
+
+            unsigned int age = cache.Time - cache.Timestamps[vertex];
+            int priority = age + 2 * live[vertex] <= VERTEX_CACHE_SIZE ? (int)age : 0;
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                next = vertex;
+            }
+        }
+
+        while (next == INVALID_VERTEX && !deadEnd.empty()) {
+            unsigned int vertex = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[vertex] > 0) {
+                next = vertex;
+            }
+        }
+
+        if (next == INVALID_VERTEX) {
+            for (; inputCursor < vertexCount; inputCursor++) {
+                if (live[inputCursor] > 0) {
+                    next = inputCursor;
+                    clusters.push_back((unsigned int)(output.size() / 3));
+                    break;
+                }
+            }
+        }
+
+        fan = next;
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+/* OptimizeOverdraw follows Sander et al. 2007: clusters are split where the running ACMR of the current piece drops
+ * below threshold times the ACMR of the whole cluster, then sorted by how much they face away from the mesh center.
+ * Every piece starts from a cold cache since the pieces end up in arbitrary order. */
+void OptimizeOverdraw(unsigned int* indices, const size_t indexCount, const Vertex* vertices,
+                      const unsigned int vertexCount, const std::vector<unsigned int>& clusters,
+                      const float threshold) {
+    unsigned int triangleCount = (unsigned int)(indexCount / 3);
+    if (triangleCount == 0 || clusters.empty()) {
+        return;
+    }
+
+    VertexCache cache(vertexCount);
+    std::vector<unsigned int> pieces;
+    for (size_t c = 0; c < clusters.size(); c++) {
+        unsigned int begin = clusters[c];
+        unsigned int end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+        cache.Flush();
+        unsigned int clusterMisses = 0;
+        for (unsigned int t = begin; t < end; t++) {
+            for (unsigned int i = 0; i < 3; i++) {
+                clusterMisses += cache.Access(indices[t * 3 + i]);
+            }
+        }
+        float clusterACMR = (float)clusterMisses / (float)(end - begin);
+
+        cache.Flush();
+        pieces.push_back(begin);
+        unsigned int misses = 0, triangles = 0;
+        for (unsigned int t = begin; t < end; t++) {
+            for (unsigned int i = 0; i < 3; i++) {
+                misses += cache.Access(indices[t * 3 + i]);
+            }
+            triangles++;
+
+            if (t + 1 < end && (float)misses <= threshold * clusterACMR * (float)triangles) {
+                pieces.push_back(t + 1);
+                misses = 0;
+                triangles = 0;
+                cache.Flush();
+            }
+        }
+    }
+
+    // Mesh center and per piece centroid and area weighted normal
+    std::vector<glm::vec3> centroids(pieces.size(), glm::vec3(0.0f));
+    std::vector<glm::vec3> normals(pieces.size(), glm::vec3(0.0f));
+    glm::vec3 center(0.0f);
+    for (size_t p = 0; p < pieces.size(); p++) {
+        unsigned int begin = pieces[p];
+        unsigned int end = p + 1 < pieces.size() ? pieces[p + 1] : triangleCount;
+        for (unsigned int t = begin; t < end; t++) {
+            const glm::vec3& a = vertices[indices[t * 3 + 0]].Position;
+            const glm::vec3& b = vertices[indices[t * 3 + 1]].Position;
+            const glm::vec3& c = vertices[indices[t * 3 + 2]].Position;
+            centroids[p] += (a + b + c) / 3.0f;
+            normals[p] += glm::cross(b - a, c - a);
+        }
+
+        center += centroids[p];
+        centroids[p] /= (float)(end - begin);
+    }
+    center /= (float)triangleCount;
+
+    std::vector<float> keys(pieces.size(), 0.0f);
+    for (size_t p = 0; p < pieces.size(); p++) {
+        float length = glm::length(normals[p]);
+        if (length > 0.0f) {
+            keys[p] = glm::dot(centroids[p] - center, normals[p] / length);
+        }
+    }
+
+    std::vector<unsigned int> order(pieces.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&keys](unsigned int a, unsigned int b) { return keys[a] > keys[b]; });
+
+    std::vector<unsigned int> sorted;
+    sorted.reserve(indexCount);
+    for (unsigned int p : order) {
+        unsigned int begin = pieces[p];
+        unsigned int end = p + 1 < pieces.size() ? pieces[p + 1] : triangleCount;
+        sorted.insert(sorted.end(), indices + begin * 3, indices + end * 3);
+    }
+
+    std::copy(sorted.begin(), sorted.end(), indices);
+}
+
+void OptimizeVertexFetch(Vertex* vertices, const unsigned int vertexCount, unsigned int* indices,
+                         const size_t indexCount) {
+    std::vector<unsigned int> remap(vertexCount, INVALID_VERTEX);
+    unsigned int next = 0;
+    for (size_t i = 0; i < indexCount; i++) {
+        if (remap[indices[i]] == INVALID_VERTEX) {
+            remap[indices[i]] = next++;
+        }
+        indices[i] = remap[indices[i]];
+    }
+
+    for (unsigned int v = 0; v < vertexCount; v++) {
+        if (remap[v] == INVALID_VERTEX) {
+            remap[v] = next++;
+        }
+    }
+
+    std::vector<Vertex> original(vertices, vertices + vertexCount);
+    for (unsigned int v = 0; v < vertexCount; v++) {
+        vertices[remap[v]] = original[v];
+    }
+}
@@ -0,0 +1,246 @@
+#include <scene/mesh_simplifier.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <tuple>
+#include <unordered_map>
+
+/* Quadric is a sum of squared distances to planes, weighted by triangle area. Evaluating it divides by the total
+ * weight, which gives the mean squared distance of a point to the planes. */
+struct Quadric {
+    double A00 = 0.0, A11 = 0.0, A22 = 0.0, A01 = 0.0, A02 = 0.0, A12 = 0.0;
+    double B0 = 0.0, B1 = 0.0, B2 = 0.0;
+    double C = 0.0;
+    double W = 0.0;
+
+    Quadric& operator+=(const Quadric& q) {
+        A00 += q.A00, A11 += q.A11, A22 += q.A22, A01 += q.A01, A02 += q.A02, A12 += q.A12;
+        B0 += q.B0, B1 += q.B1, B2 += q.B2;
+        C += q.C;
+        W += q.W;
+        return *this;
+    }
+
+    // Plane n . p + d = 0 with a unit normal
+    void AddPlane(const glm::vec3& n, const float d, const float weight) {
+        A00 += weight * n.x * n.x, A11 += weight * n.y * n.y, A22 += weight * n.z * n.z;
+        A01 += weight * n.x * n.y, A02 += weight * n.x * n.z, A12 += weight * n.y * n.z;
+        B0 += weight * n.x * d, B1 += weight * n.y * d, B2 += weight * n.z * d;
+        C += weight * d * d;
+        W += weight;
+    }
+
+    float Evaluate(const glm::vec3& p) const {
+        if (W == 0.0) {
+            return 0.0f;
+        }
+
+        double x = p.x, y = p.y, z = p.z;
+        double error = A00 * x * x + A11 * y * y + A22 * z * z + 2.0 * (A01 * x * y + A02 * x * z + A12 * y * z) +
+                       2.0 * (B0 * x + B1 * y + B2 * z) + C;
+        return (float)std::max(error / W, 0.0);
+    }
+};
+
+/* Collapse moves vertex From onto its neighbour To */
+struct Collapse {
+    unsigned int From, To;
+    float Cost;
+};
+
+/* findPositions maps every vertex to the first vertex at the same position, vertices which only differ in their
+ * normal or texture coordinate share the position */
+static std::vector<unsigned int> findPositions(const Vertex* vertices, const unsigned int vertexCount) {
+    std::vector<unsigned int> order(vertexCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [vertices](unsigned int a, unsigned int b) {
+        const glm::vec3& pa = vertices[a].Position;
+        const glm::vec3& pb = vertices[b].Position;
+        return std::tie(pa.x, pa.y, pa.z) < std::tie(pb.x, pb.y, pb.z);
+    });
+
+    std::vector<unsigned int> positions(vertexCount);
+    for (unsigned int i = 0; i < vertexCount; i++) {
+        bool same = i > 0 && vertices[order[i]].Position == vertices[order[i - 1]].Position;
+        positions[order[i]] = same ? positions[order[i - 1]] : order[i];
+    }
+
+    return positions;
+}
+
+/* findLocked marks the positions that may not move: attribute seams and vertices of edges that are not shared by
+ * exactly two triangles */
+static std::vector<bool> findLocked(const std::vector<unsigned int>& positions, const unsigned int* indices,
+                                    const size_t indexCount) {
+    std::vector<bool> locked(positions.size(), false);
+    for (unsigned int v = 0; v < positions.size(); v++) {
+        if (positions[v] != v) {
+            locked[positions[v]] = true;
+        }
+    }
+
+    std::unordered_map<uint64_t, unsigned int> edges;
+    for (size_t i = 0; i < indexCount; i += 3) {
+        for (unsigned int e = 0; e < 3; e++) {
+            unsigned int a = positions[indices[i + e]];
+            unsigned int b = positions[indices[i + (e + 1) % 3]];
+            edges[((uint64_t)std::min(a, b) << 32) | std::max(a, b)]++;
+        }
+    }
+
+    for (const std::pair<const uint64_t, unsigned int>& edge : edges) {
+        if (edge.second != 2) {
+            locked[(unsigned int)(edge.first >> 32)] = true;
+            locked[(unsigned int)(edge.first & 0xffffffff)] = true;
+        }
+    }
+
+    return locked;
+}
+
+static glm::vec3 triangleNormal(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2) {
+    return glm::cross(p1 - p0, p2 - p0);
+}
+
+/* SimplifyMesh collapses edges in passes. Every pass collapses the cheapest edges whose neighbourhoods are untouched
+ * by earlier collapses of the pass, so that the flip check of each collapse stays valid, then removes the triangles
+ * that became degenerate. */
+float SimplifyMesh(const Vertex* vertices, const unsigned int vertexCount, const unsigned int* indices,
+                   const size_t indexCount, const size_t targetIndexCount, std::vector<unsigned int>& result) {
+    result.assign(indices, indices + indexCount);
+    if (indexCount <= targetIndexCount || vertexCount == 0) {
+        return 0.0f;
+    }
+
+    std::vector<unsigned int> positions = findPositions(vertices, vertexCount);
+    std::vector<bool> locked = findLocked(positions, indices, indexCount);
+
+    // Quadrics live at the position, all vertices of a seam share one
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < indexCount; i += 3) {
+        const glm::vec3& p0 = vertices[indices[i + 0]].Position;
+        glm::vec3 normal = triangleNormal(p0, vertices[indices[i + 1]].Position, vertices[indices[i + 2]].Position);
+        float length = glm::length(normal);
+        if (length == 0.0f) {
+            continue;
+        }
+
+        normal /= length;
+        for (unsigned int k = 0; k < 3; k++) {
+            quadrics[positions[indices[i + k]]].AddPlane(normal, -glm::dot(normal, p0), length * 0.5f);
+        }
+    }
+
+    float maxError = 0.0f;
+    std::vector<unsigned int> collapses(vertexCount);
+    std::vector<bool> touched(vertexCount);
+    std::vector<unsigned int> adjacencyOffsets(vertexCount + 1), adjacency;
+    std::vector<Collapse> candidates;
+
+    while (result.size() > targetIndexCount) {
+        size_t triangleCount = result.size() / 3;
+
+        // Triangles around every vertex
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (unsigned int index : result) {
+            adjacencyOffsets[index + 1]++;
+        }
+        std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+        adjacency.resize(result.size());
+        std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < result.size(); i++) {
+            adjacency[fill[result[i]]++] = (unsigned int)(i / 3);
+        }
+
+        // Both directions of every edge whose source may move
+        candidates.clear();
+        for (size_t i = 0; i < result.size(); i += 3) {
+            for (unsigned int e = 0; e < 3; e++) {
+                unsigned int a = result[i + e];
+                unsigned int b = result[i + (e + 1) % 3];
+                Quadric q = quadrics[positions[a]];
+                q += quadrics[positions[b]];
+                if (!locked[positions[a]]) {
+                    candidates.push_back({a, b, q.Evaluate(vertices[b].Position)});
+                }
+                if (!locked[positions[b]]) {
+                    candidates.push_back({b, a, q.Evaluate(vertices[a].Position)});
+                }
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const Collapse& a, const Collapse& b) { return a.Cost < b.Cost; });
+
+        // An interior collapse removes two triangles
+        size_t limit = std::max((size_t)(triangleCount * SIMPLIFY_PASS_RATIO), (size_t)1);
+        limit = std::min(limit, (triangleCount - targetIndexCount / 3 + 1) / 2);
+
+        std::iota(collapses.begin(), collapses.end(), 0);
+        std::fill(touched.begin(), touched.end(), false);
+        size_t collapsed = 0;
+        for (const Collapse& c : candidates) {
+            if (collapsed >= limit) {
+                break;
+            }
+            if (touched[c.From] || touched[c.To]) {
+                continue;
+            }
+
+            // Reject collapses that turn a remaining triangle around or stand it on its edge
+            bool flips = false;
+            for (unsigned int t = adjacencyOffsets[c.From]; t < adjacencyOffsets[c.From + 1] && !flips; t++) {
+                const unsigned int* tri = &result[adjacency[t] * 3];
+                if (positions[tri[0]] == positions[c.To] || positions[tri[1]] == positions[c.To] ||
+                    positions[tri[2]] == positions[c.To]) {
+                    continue;
+                }
+
+                glm::vec3 p[3], moved[3];
+                for (unsigned int k = 0; k < 3; k++) {
+                    p[k] = vertices[tri[k]].Position;
+                    moved[k] = tri[k] == c.From ? vertices[c.To].Position : p[k];
+                }
+                glm::vec3 before = triangleNormal(p[0], p[1], p[2]);
+                glm::vec3 after = triangleNormal(moved[0], moved[1], moved[2]);
+                flips = glm::dot(before, after) <= SIMPLIFY_MIN_NORMAL_COS * glm::length(before) * glm::length(after);
+            }
+            if (flips) {
+                continue;
+            }
+
+            collapses[c.From] = c.To;
+            touched[c.To] = true;
+            for (unsigned int t = adjacencyOffsets[c.From]; t < adjacencyOffsets[c.From + 1]; t++) {
+                const unsigned int* tri = &result[adjacency[t] * 3];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = true;
+            }
+
+            quadrics[positions[c.To]] += quadrics[positions[c.From]];
+            maxError = std::max(maxError, c.Cost);
+            collapsed++;
+        }
+
+        if (collapsed == 0) {
+            break;
+        }
+
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3) {
+            unsigned int a = collapses[result[i + 0]];
+            unsigned int b = collapses[result[i + 1]];
+            unsigned int c = collapses[result[i + 2]];
+            if (positions[a] == positions[b] || positions[b] == positions[c] || positions[a] == positions[c]) {
+                continue;
+            }
+
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    return std::sqrt(maxError);
+}
@@ -0,0 +1,117 @@
+#include <scene/mesh.h>
+#include <scene/meshlet.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+/* computeBounds fills the bounding sphere and normal cone of the triangles [FirstIndex, FirstIndex + IndexCount) */
+static void computeBounds(const Vertex* vertices, const unsigned int* indices, Meshlet& meshlet) {
+    const unsigned int* begin = indices + meshlet.FirstIndex;
+    const unsigned int* end = begin + meshlet.IndexCount;
+
+    // Sphere around the box center, loose but cheap and stable
+    glm::vec3 lo = vertices[*begin].Position, hi = lo;
+    for (const unsigned int* i = begin; i != end; i++) {
+        lo = glm::min(lo, vertices[*i].Position);
+        hi = glm::max(hi, vertices[*i].Position);
+    }
+    meshlet.Center = (lo + hi) * 0.5f;
+    meshlet.Radius = 0.0f;
+    for (const unsigned int* i = begin; i != end; i++) {
+        meshlet.Radius = std::max(meshlet.Radius, glm::length(vertices[*i].Position - meshlet.Center));
+    }
+
+    // Cone around the average of the triangle normals, degenerate triangles do not face any direction
+    std::vector<glm::vec3> normals;
+    glm::vec3 axis(0.0f);
+    for (const unsigned int* i = begin; i != end; i += 3) {
+        const glm::vec3& p0 = vertices[i[0]].Position;
+        glm::vec3 normal = glm::cross(vertices[i[1]].Position - p0, vertices[i[2]].Position - p0);
+        float length = glm::length(normal);
+        if (length > 0.0f) {
+            normals.push_back(normal / length);
+            axis += normals.back();
+        }
+    }
+
+    float axisLength = glm::length(axis);
+    meshlet.ConeAxis = axisLength > 0.0f ? axis / axisLength : glm::vec3(0.0f, 0.0f, 1.0f);
+    float minDot = axisLength > 0.0f ? 1.0f : -1.0f;
+    for (const glm::vec3& normal : normals) {
+        minDot = std::min(minDot, glm::dot(normal, meshlet.ConeAxis));
+    }
+
+    // A cone wider than a half space never faces away from every viewpoint
+    meshlet.ConeCutoff = minDot <= 0.0f ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+}
+
+void BuildMeshlets(const Vertex* vertices, const unsigned int vertexCount, const unsigned int* indices,
+                   const size_t indexCount, std::vector<Meshlet>& meshlets) {
+    // Last meshlet that used each vertex, so counting unique vertices needs no clearing
+    std::vector<unsigned int> used(vertexCount, UINT32_MAX);
+
+    Meshlet meshlet = {};
+    unsigned int meshletVertices = 0;
+    for (size_t i = 0; i + 3 <= indexCount; i += 3) {
+        // Vertices of the triangle new to the meshlet, counting repeated indices once
+        unsigned int id = (unsigned int)meshlets.size();
+        unsigned int added = 0;
+        for (unsigned int k = 0; k < 3; k++) {
+            unsigned int v = indices[i + k];
+            added += used[v] != id && (k < 1 || v != indices[i]) && (k < 2 || v != indices[i + 1]);
+        }
+
+        if (meshletVertices + added > MESHLET_MAX_VERTICES || meshlet.IndexCount / 3 == MESHLET_MAX_TRIANGLES) {
+            computeBounds(vertices, indices, meshlet);
+            meshlets.push_back(meshlet);
+            meshlet = {};
+            meshlet.FirstIndex = (unsigned int)i;
+            meshletVertices = 0;
+            id++;
+        }
+
+        for (unsigned int k = 0; k < 3; k++) {
+            if (used[indices[i + k]] != id) {
+                used[indices[i + k]] = id;
+                meshletVertices++;
+            }
+        }
+        meshlet.IndexCount += 3;
+    }
+
+    if (meshlet.IndexCount > 0) {
+        computeBounds(vertices, indices, meshlet);
+        meshlets.push_back(meshlet);
+    }
+}
+
+/* ExtractFrustum reads the planes off the rows of the matrix (Gribb and Hartmann) */
+Frustum ExtractFrustum(const glm::mat4& matrix) {
+    glm::mat4 rows = glm::transpose(matrix);
+
+    Frustum frustum;
+    frustum.Planes[0] = rows[3] + rows[0];
+    frustum.Planes[1] = rows[3] - rows[0];
+    frustum.Planes[2] = rows[3] + rows[1];
+    frustum.Planes[3] = rows[3] - rows[1];
+    frustum.Planes[4] = rows[3] + rows[2];
+    frustum.Planes[5] = rows[3] - rows[2];
+    for (glm::vec4& plane : frustum.Planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+
+    return frustum;
+}
+
+bool IsMeshletVisible(const Meshlet& meshlet, const Frustum& frustum, const glm::vec3& cameraPosition) {
+    for (const glm::vec4& plane : frustum.Planes) {
+        if (glm::dot(glm::vec3(plane), meshlet.Center) + plane.w < -meshlet.Radius) {
+            return false;
+        }
+    }
+
+    // Every triangle faces away from every point of the bounding sphere as seen from the camera
+    glm::vec3 view = meshlet.Center - cameraPosition;
+    return glm::dot(view, meshlet.ConeAxis) < meshlet.ConeCutoff * glm::length(view) + meshlet.Radius;
+}
@@ -1,13 +1,110 @@
 #include <assimp/postprocess.h>
 #include <common.h>
+#include <core/parallel.h>
+#include <renderer/texture_cache.h>
+#include <renderer/texture_streamer.h>
 #include <scene/model.h>
 
+#include <algorithm>
 #include <assimp/Importer.hpp>
+#include <limits>
 #include <stdexcept>
 
-Model::Model(const std::string& filePath) : m_FilePath(filePath) {
+Model::Model(const std::string& filePath, const TextureOptions& textureOptions)
+    : m_FilePath(filePath), m_TextureOptions(textureOptions), m_BoundingRadius(0.0f) {
+    m_Directory = std::filesystem::path(filePath).parent_path();
+    std::string cachePath = GetMeshCachePath(filePath);
+
+    {
+        // Upload straight from the mapping, the cache is closed before it could be rewritten below
+        MeshCacheFile cache(cachePath, filePath);
+        if (cache.IsValid()) {
+            m_BoundingRadius = cache.GetBoundingRadius();
+            setupGeometry(cache.GetVertices(), cache.GetVertexCount(), cache.GetIndices(), cache.GetIndexCount(),
+                          cache.GetMeshes());
+            setupIndirect();
+            spdlog::debug("Model '{}' loaded from mesh cache", filePath);
+            return;
+        }
+    }
+
+    MeshCacheData data;
+    importModel(data);
+    WriteMeshCache(cachePath, filePath, data);
+
+    // Upload all meshes as one block
+    m_BoundingRadius = data.BoundingRadius;
+    setupGeometry(data.PackedVertices.data(), (unsigned int)data.PackedVertices.size(), data.Indices.data(),
+                  (unsigned int)data.Indices.size(), data.Meshes);
+    setupIndirect();
+}
+
+Model::~Model() {
+    // Meshes and the VAO reference the arena page, release them before the block
+    m_Meshes.clear();
+    m_VAO.reset();
+    Mesh::GetArena().Free(m_Geometry);
+}
+
+/* SetupDraw binds the textures of one batch and its per-draw material table for indirect drawing */
+void Model::SetupDraw(Shader& shader, unsigned int batch) const {
+    shader.Bind();
+
+    const IndirectBatch& b = m_IndirectBatches[batch];
+    int units[MAX_INDIRECT_TEXTURES] = {};
+    for (unsigned int i = 0; i < b.Textures.size(); i++) {
+        b.Textures[i]->Bind(i);
+        units[i] = (int)i;
+    }
+
+    if (!b.Textures.empty()) {
+        shader.SetUniform1iv("u_Textures", (unsigned int)b.Textures.size(), units);
+    }
+    b.Materials->BindBase(INDIRECT_MATERIAL_BINDING);
+}
+
+void Model::AddInstancedBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout) const {
+    if (m_Meshes.empty()) {
+        return;
+    }
+
+    // All meshes live in the same arena page, so they can share one private VAO with the instanced attributes
+    if (!m_VAO) {
+        m_VAO = Mesh::GetArena().CreateVertexArray(*m_Geometry.Page);
+        for (const std::shared_ptr<Mesh>& mesh : m_Meshes) {
+            mesh->SetVertexArray(m_VAO);
+        }
+    }
+    m_VAO->AddBuffer(vb, layout, true);
+}
+
+void Model::StreamTextures(float footprint) const {
+    for (const std::shared_ptr<Mesh>& mesh : m_Meshes) {
+        for (const std::shared_ptr<Texture>& tex : mesh->GetTextures()) {
+            TextureStreamer::Request(*tex, footprint);
+        }
+    }
+}
+
+unsigned int Model::SelectLod(float footprint) const {
+    // The footprint covers the bounding diameter, errors are relative to the bounding radius
+    unsigned int lod = 0;
+    while (lod + 1 < m_LodErrors.size() && m_LodErrors[lod + 1] * footprint * 0.5f <= LOD_PIXEL_ERROR) {
+        lod++;
+    }
+
+    return lod;
+}
+
+float Model::GetLodFootprint(unsigned int lod) const {
+    float error = m_LodErrors[std::min(lod, (unsigned int)m_LodErrors.size() - 1)];
+    return error > 0.0f ? 2.0f * LOD_PIXEL_ERROR / error : std::numeric_limits<float>::max();
+}
+
+/* importModel runs Assimp and flattens the meshes of all nodes into one vertex and index stream */
+void Model::importModel(MeshCacheData& data) {
     Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(filePath, aiProcess_Triangulate | aiProcess_FlipUVs);
+    const aiScene* scene = importer.ReadFile(m_FilePath, aiProcess_Triangulate | aiProcess_FlipUVs);
 
     // Check for empty scene / empty root node / incomplete scene
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
@@ -15,43 +112,296 @@ Model::Model(const std::string& filePath) : m_FilePath(filePath) {
         throw std::runtime_error("Failed to import model");
     }
 
-    m_Directory = std::filesystem::path(filePath).parent_path();
     // Process root node recursively
-    processNode(scene->mRootNode, scene);
+    std::vector<const aiMesh*> meshes;
+    collectMeshes(scene->mRootNode, scene, meshes);
+
+    // Size the streams up front so that every task writes its own range without synchronization
+    std::vector<ImportTask> tasks;
+    unsigned int vertexCount = 0;
+    unsigned int indexCount = 0;
+    for (const aiMesh* mesh : meshes) {
+        CachedMesh entry;
+        entry.BaseVertex = vertexCount;
+        entry.VertexCount = mesh->mNumVertices;
+        entry.FirstIndex = indexCount;
+
+        for (unsigned int begin = 0; begin < mesh->mNumVertices; begin += IMPORT_CHUNK_SIZE) {
+            unsigned int end = std::min(begin + IMPORT_CHUNK_SIZE, mesh->mNumVertices);
+            tasks.push_back({mesh, false, begin, end, vertexCount + begin});
+        }
+        for (unsigned int begin = 0; begin < mesh->mNumFaces; begin += IMPORT_CHUNK_SIZE) {
+            unsigned int end = std::min(begin + IMPORT_CHUNK_SIZE, mesh->mNumFaces);
+            tasks.push_back({mesh, true, begin, end, indexCount});
+            // Triangulated faces still include points and lines
+            for (unsigned int i = begin; i < end; i++) {
+                indexCount += mesh->mFaces[i].mNumIndices;
+            }
+        }
+        entry.IndexCount = indexCount - entry.FirstIndex;
+
+        // Process mesh material texture
+        aiMaterial* mat = scene->mMaterials[mesh->mMaterialIndex];
+        // Diffuse texture maps
+        std::vector<MeshTexture> diffuseMaps = loadMaterialTextures(mat, aiTextureType_DIFFUSE, TextureType::Diffuse);
+        entry.Textures.insert(entry.Textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+        // Specular textures maps
+        std::vector<MeshTexture> specularMaps =
+            loadMaterialTextures(mat, aiTextureType_SPECULAR, TextureType::Specular);
+        entry.Textures.insert(entry.Textures.end(), specularMaps.begin(), specularMaps.end());
+
+        vertexCount += mesh->mNumVertices;
+        data.Meshes.push_back(std::move(entry));
+    }
+
+    data.Vertices.resize(vertexCount);
+    data.Indices.resize(indexCount);
+
+    std::vector<float> radii(tasks.size(), 0.0f);
+    Parallel::For((unsigned int)tasks.size(), [&](unsigned int i) { radii[i] = processTask(tasks[i], data); });
+    for (float radius : radii) {
+        data.BoundingRadius = std::max(data.BoundingRadius, radius);
+    }
+
+    // Weld triangle meshes, reorder them for the post-transform cache, overdraw and vertex fetch and simplify them
+    // into levels of detail, the cache keeps the result
+    std::vector<VertexCacheStats> before(meshes.size()), after(meshes.size());
+    std::vector<unsigned int> importedVertices(meshes.size());
+    std::vector<std::vector<unsigned int>> lodIndices(meshes.size());
+    Parallel::For((unsigned int)meshes.size(), [&](unsigned int i) {
+        CachedMesh& mesh = data.Meshes[i];
+        importedVertices[i] = mesh.VertexCount;
+        before[i] = AnalyzeVertexCache(data.Indices.data() + mesh.FirstIndex, mesh.IndexCount, mesh.VertexCount);
+        after[i] = before[i];
+        if (meshes[i]->mPrimitiveTypes == aiPrimitiveType_TRIANGLE) {
+            after[i] = optimizeMesh(mesh, data);
+            buildLods(mesh, data, lodIndices[i]);
+            buildMeshlets(mesh, data);
+        }
+    });
+
+    // Levels of detail go after the indices of all meshes
+    for (unsigned int i = 0; i < meshes.size(); i++) {
+        CachedMesh& mesh = data.Meshes[i];
+        for (MeshLod& lod : mesh.Lods) {
+            lod.FirstIndex += (unsigned int)data.Indices.size();
+        }
+        data.Indices.insert(data.Indices.end(), lodIndices[i].begin(), lodIndices[i].end());
+
+        spdlog::debug(
+            "Mesh {} of '{}': {} -> {} vertices, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}, {} LODs, {} meshlets", i,
+            m_FilePath, importedVertices[i], mesh.VertexCount, before[i].ACMR, after[i].ACMR, before[i].ATVR,
+            after[i].ATVR, mesh.Lods.size(), mesh.Meshlets.size());
+    }
+
+    // Welding leaves the dropped vertices at the end of each mesh range, close the gaps
+    vertexCount = 0;
+    for (CachedMesh& mesh : data.Meshes) {
+        std::copy(data.Vertices.begin() + mesh.BaseVertex, data.Vertices.begin() + mesh.BaseVertex + mesh.VertexCount,
+                  data.Vertices.begin() + vertexCount);
+        mesh.BaseVertex = vertexCount;
+        vertexCount += mesh.VertexCount;
+    }
+    data.Vertices.resize(vertexCount);
+
+    // Halves the vertex stream, the import passes above still see full precision
+    data.PackedVertices.resize(vertexCount);
+    PackVertices(data.Vertices.data(), vertexCount, data.PackedVertices.data());
+    spdlog::debug("Model '{}' vertex stream packed from {} to {} bytes", m_FilePath, vertexCount * sizeof(Vertex),
+                  vertexCount * sizeof(PackedVertex));
 }
 
-void Model::SetupDraw(Shader& shader) const {
-    for (unsigned int i = 0; i < m_Meshes.size(); i++) {
-        m_Meshes[i]->SetupDraw(shader);
+/* optimizeMesh runs the mesh optimizer passes on the range of one mesh in the model streams, welding shrinks the
+ * vertex count of the mesh */
+VertexCacheStats Model::optimizeMesh(CachedMesh& mesh, MeshCacheData& data) {
+    Vertex* vertices = data.Vertices.data() + mesh.BaseVertex;
+    unsigned int* indices = data.Indices.data() + mesh.FirstIndex;
+    mesh.VertexCount = WeldVertices(vertices, mesh.VertexCount, indices, mesh.IndexCount, IMPORT_WELD_EPSILON);
+
+    std::vector<unsigned int> clusters;
+    OptimizeVertexCache(indices, mesh.IndexCount, mesh.VertexCount, clusters);
+    OptimizeOverdraw(indices, mesh.IndexCount, vertices, mesh.VertexCount, clusters);
+    OptimizeVertexFetch(vertices, mesh.VertexCount, indices, mesh.IndexCount);
+
+    return AnalyzeVertexCache(indices, mesh.IndexCount, mesh.VertexCount);
+}
+
+/* buildLods simplifies a mesh into coarser and coarser levels, each from the full mesh so that errors do not add up.
+ * The level indices are appended to indices, the level ranges are relative to it. */
+void Model::buildLods(CachedMesh& mesh, const MeshCacheData& data, std::vector<unsigned int>& indices) {
+    const Vertex* vertices = data.Vertices.data() + mesh.BaseVertex;
+    const unsigned int* meshIndices = data.Indices.data() + mesh.FirstIndex;
+
+    size_t previousCount = mesh.IndexCount;
+    float targetCount = (float)mesh.IndexCount;
+    std::vector<unsigned int> lod, clusters;
+    for (unsigned int level = 1; level < MAX_LOD_LEVELS; level++) {
+        targetCount *= LOD_TRIANGLE_RATIO;
+        float error =
+            SimplifyMesh(vertices, mesh.VertexCount, meshIndices, mesh.IndexCount, (size_t)targetCount / 3 * 3, lod);
+        if (lod.empty() || lod.size() > previousCount * LOD_MIN_REDUCTION) {
+            break;
+        }
+
+        OptimizeVertexCache(lod.data(), lod.size(), mesh.VertexCount, clusters);
+        mesh.Lods.push_back({(unsigned int)indices.size(), (unsigned int)lod.size(), error});
+        indices.insert(indices.end(), lod.begin(), lod.end());
+        previousCount = lod.size();
     }
 }
 
-void Model::AddInstancedBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout) const {
-    for (unsigned int i = 0; i < m_Meshes.size(); i++) {
-        m_Meshes[i]->AddInstancedBuffer(vb, layout);
+/* buildMeshlets splits the full detail triangles of a mesh into clusters, after the vertex cache order is final */
+void Model::buildMeshlets(CachedMesh& mesh, const MeshCacheData& data) {
+    BuildMeshlets(data.Vertices.data() + mesh.BaseVertex, mesh.VertexCount, data.Indices.data() + mesh.FirstIndex,
+                  mesh.IndexCount, mesh.Meshlets);
+}
+
+/* setupGeometry allocates one contiguous arena block for all meshes, each mesh is a sub-range of it */
+void Model::setupGeometry(const PackedVertex* vertices, unsigned int vertexCount, const unsigned int* indices,
+                          unsigned int indexCount, const std::vector<CachedMesh>& meshes) {
+    m_Geometry = Mesh::GetArena().Allocate(vertices, vertexCount, indices, indexCount);
+
+    // Indices stay relative to each mesh, the mesh offset is applied as base vertex when drawing
+    m_LodErrors.assign(1, 0.0f);
+    for (const CachedMesh& mesh : meshes) {
+        GeometryRange range;
+        range.Page = m_Geometry.Page;
+        range.BaseVertex = m_Geometry.BaseVertex + (int)mesh.BaseVertex;
+        range.VertexCount = mesh.VertexCount;
+        range.FirstIndex = m_Geometry.FirstIndex + mesh.FirstIndex;
+        range.IndexCount = mesh.IndexCount;
+
+        std::vector<GeometryRange> lods;
+        for (const MeshLod& lod : mesh.Lods) {
+            GeometryRange lodRange = range;
+            lodRange.FirstIndex = m_Geometry.FirstIndex + lod.FirstIndex;
+            lodRange.IndexCount = lod.IndexCount;
+            lods.push_back(lodRange);
+        }
+        m_LodErrors.resize(std::max(m_LodErrors.size(), mesh.Lods.size() + 1), 0.0f);
+        m_Meshes.push_back(std::make_shared<Mesh>(range, acquireTextures(mesh.Textures), lods, mesh.Meshlets));
+    }
+
+    // Meshes with fewer levels draw their coarsest one at the levels they lack
+    float scale = m_BoundingRadius > 0.0f ? 1.0f / m_BoundingRadius : 0.0f;
+    for (const CachedMesh& mesh : meshes) {
+        for (unsigned int level = 1; level < m_LodErrors.size() && !mesh.Lods.empty(); level++) {
+            float error = mesh.Lods[std::min(level, (unsigned int)mesh.Lods.size()) - 1].Error;
+            m_LodErrors[level] = std::max(m_LodErrors[level], error * scale);
+        }
     }
 }
 
-void Model::processNode(aiNode* node, const aiScene* scene) {
+/* setupIndirect builds one indirect command per mesh and level of detail and one material entry per mesh, the
+ * commands address the mesh ranges of the model block. Meshes are split into batches so that every multi-draw reads at
+ * most MAX_INDIRECT_TEXTURES textures. */
+void Model::setupIndirect() {
+    std::vector<std::vector<DrawElementsIndirectCommand>> commands(m_LodErrors.size());
+    std::vector<IndirectMaterial> materials;
+    std::vector<std::shared_ptr<Texture>> textures;
+    std::unordered_map<const Texture*, int> textureUnits;
+
+    for (const std::shared_ptr<Mesh>& mesh : m_Meshes) {
+        // The material reads the first diffuse and the first specular texture of the mesh
+        std::shared_ptr<Texture> diffuse, specular;
+        for (const std::shared_ptr<Texture>& tex : mesh->GetTextures()) {
+            if (tex->GetType() == TextureType::Diffuse && !diffuse) {
+                diffuse = tex;
+            } else if (tex->GetType() == TextureType::Specular && !specular) {
+                specular = tex;
+            }
+        }
+
+        // Start a new batch when the textures of the mesh do not fit into the units left
+        unsigned int added = 0;
+        added += diffuse && textureUnits.find(diffuse.get()) == textureUnits.end() ? 1 : 0;
+        added += specular && specular != diffuse && textureUnits.find(specular.get()) == textureUnits.end() ? 1 : 0;
+        if (textures.size() + added > MAX_INDIRECT_TEXTURES) {
+            addIndirectBatch(commands, materials, textures);
+            textureUnits.clear();
+        }
+
+        auto unitOf = [&](const std::shared_ptr<Texture>& tex) {
+            if (!tex) {
+                return -1;
+            }
+
+            std::unordered_map<const Texture*, int>::iterator it = textureUnits.find(tex.get());
+            if (it == textureUnits.end()) {
+                it = textureUnits.emplace(tex.get(), (int)textures.size()).first;
+                textures.push_back(tex);
+            }
+            return it->second;
+        };
+        materials.push_back({unitOf(diffuse), unitOf(specular)});
+
+        // gl_DrawID is the mesh index within the batch at every level, so all levels share the material table
+        for (unsigned int level = 0; level < commands.size(); level++) {
+            const GeometryRange& range = mesh->GetLod(level);
+            commands[level].push_back({range.IndexCount, 1, range.FirstIndex, range.BaseVertex, 0});
+        }
+    }
+    addIndirectBatch(commands, materials, textures);
+
+    if (m_IndirectBatches.size() > 1) {
+        spdlog::debug("Model '{}' uses more than {} textures, drawn with {} multi-draws", m_FilePath,
+                      MAX_INDIRECT_TEXTURES, m_IndirectBatches.size());
+    }
+}
+
+/* addIndirectBatch turns the commands, materials and textures collected so far into a batch and clears them */
+void Model::addIndirectBatch(std::vector<std::vector<DrawElementsIndirectCommand>>& commands,
+                             std::vector<IndirectMaterial>& materials,
+                             std::vector<std::shared_ptr<Texture>>& textures) {
+    if (materials.empty()) {
+        return;
+    }
+
+    IndirectBatch batch;
+    for (std::vector<DrawElementsIndirectCommand>& levelCommands : commands) {
+        batch.Buffers.push_back(std::make_shared<IndirectBuffer>(levelCommands));
+        levelCommands.clear();
+    }
+    batch.Materials = std::make_shared<ShaderStorageBuffer>(
+        materials.data(), (unsigned int)(materials.size() * sizeof(IndirectMaterial)));
+    batch.Textures.swap(textures);
+    materials.clear();
+
+    m_IndirectBatches.push_back(std::move(batch));
+}
+
+void Model::collectMeshes(aiNode* node, const aiScene* scene, std::vector<const aiMesh*>& meshes) {
     // Process any meshes in the node
     for (unsigned int i = 0; i < node->mNumMeshes; i++) {
-        aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        m_Meshes.push_back(processMesh(mesh, scene));
+        meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
     }
 
     // Process each of its children
     for (unsigned int i = 0; i < node->mNumChildren; i++) {
-        processNode(node->mChildren[i], scene);
+        collectMeshes(node->mChildren[i], scene, meshes);
     }
 }
 
-std::shared_ptr<Mesh> Model::processMesh(aiMesh* mesh, const aiScene* scene) {
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
-    std::vector<std::shared_ptr<Texture>> textures;
+/* processTask runs on the import threads, returning the bounding radius of the vertices it extracted */
+float Model::processTask(const ImportTask& task, MeshCacheData& data) {
+    const aiMesh* mesh = task.Mesh;
+
+    // Process indices from mesh faces
+    if (task.Faces) {
+        unsigned int* indices = data.Indices.data() + task.Offset;
+        for (unsigned int i = task.Begin; i < task.End; i++) {
+            const aiFace& face = mesh->mFaces[i];
+            for (unsigned int j = 0; j < face.mNumIndices; j++) {
+                *indices++ = face.mIndices[j];
+            }
+        }
+        return 0.0f;
+    }
 
     // Process vertices from mesh
-    for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
+    float radius = 0.0f;
+    Vertex* vertices = data.Vertices.data() + task.Offset;
+    for (unsigned int i = task.Begin; i < task.End; i++) {
         glm::vec3 position(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
         glm::vec3 normal(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
         glm::vec2 texCoord(0.0f);
@@ -61,50 +411,31 @@ std::shared_ptr<Mesh> Model::processMesh(aiMesh* mesh, const aiScene* scene) {
             texCoord.y = mesh->mTextureCoords[0][i].y;
         }
 
-        vertices.push_back(Vertex{position, normal, texCoord});
-    }
-
-    // Process indices from mesh faces
-    for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
-        aiFace face = mesh->mFaces[i];
-        for (unsigned int j = 0; j < face.mNumIndices; j++) {
-            indices.push_back(face.mIndices[j]);
-        }
-    }
-
-    // Process mesh material texture
-    if (mesh->mMaterialIndex >= 0) {
-        aiMaterial* mat = scene->mMaterials[mesh->mMaterialIndex];
-        // Diffuse texture maps
-        std::vector<std::shared_ptr<Texture>> diffuseMaps =
-            loadMaterialTextures(mat, aiTextureType_DIFFUSE, TextureType::Diffuse);
-        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-        // Specular textures maps
-        std::vector<std::shared_ptr<Texture>> specularMaps =
-            loadMaterialTextures(mat, aiTextureType_SPECULAR, TextureType::Specular);
-        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+        *vertices++ = Vertex{position, normal, texCoord};
+        radius = std::max(radius, glm::length(position));
     }
 
-    return std::make_shared<Mesh>(vertices, indices, textures);
+    return radius;
 }
 
-std::vector<std::shared_ptr<Texture>> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType type,
-                                                                  TextureType tType) {
-    std::vector<std::shared_ptr<Texture>> textures;
+std::vector<MeshTexture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType type, TextureType tType) {
+    std::vector<MeshTexture> textures;
     for (unsigned int i = 0; i < mat->GetTextureCount(type); i++) {
         aiString str;
         mat->GetTexture(type, i, &str);
-        std::string fStr = std::string(str.C_Str());
+        textures.push_back({tType, std::string(str.C_Str())});
+    }
 
-        std::unordered_map<std::string, std::shared_ptr<Texture>>::iterator it = m_LoadedTextures.find(fStr);
-        if (it == m_LoadedTextures.end()) {
-            // Texture not already loaded, initialize it
-            m_LoadedTextures[fStr] = std::make_shared<Texture>((m_Directory / fStr).string(), tType);
-        }
+    return textures;
+}
 
-        // Push the loaded texture into return
-        textures.push_back(m_LoadedTextures[fStr]);
+std::vector<std::shared_ptr<Texture>> Model::acquireTextures(const std::vector<MeshTexture>& textures) {
+    std::vector<std::shared_ptr<Texture>> result;
+    for (const MeshTexture& texture : textures) {
+        // Shared with every other model using the same file, new textures are decoded in the background
+        result.push_back(TextureCache::Acquire((m_Directory / texture.Path).string(), texture.Type, m_TextureOptions,
+                                               true));
     }
 
-    return textures;
+    return result;
 }
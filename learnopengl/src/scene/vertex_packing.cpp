@@ -0,0 +1,117 @@
+#include <scene/vertex_packing.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+uint16_t FloatToHalf(const float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    int exponent = (int)((bits >> 23) & 0xff);
+    uint32_t mantissa = bits & 0x7fffff;
+
+    // Infinity stays infinity, NaN stays a (quiet) NaN
+    if (exponent == 0xff) {
+        return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+    }
+
+    exponent = exponent - 127 + 15;
+    if (exponent >= 0x1f) {
+        return sign | 0x7c00;
+    }
+
+    if (exponent <= 0) {
+        // Too small even for a half subnormal
+        if (exponent < -10) {
+            return sign;
+        }
+
+        mantissa |= 0x800000;
+        unsigned int shift = (unsigned int)(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1))) {
+            half++;
+        }
+        return sign | (uint16_t)half;
+    }
+
+    // Rounding up may carry into the exponent, which is still the correctly rounded result
+    uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1fff;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) {
+        half++;
+    }
+    return sign | (uint16_t)half;
+}
+
+float HalfToFloat(const uint16_t value) {
+    float sign = (value & 0x8000) ? -1.0f : 1.0f;
+    int exponent = (value >> 10) & 0x1f;
+    int mantissa = value & 0x3ff;
+
+    if (exponent == 0) {
+        return sign * std::ldexp((float)mantissa, -24);
+    }
+    if (exponent == 0x1f) {
+        return mantissa ? std::numeric_limits<float>::quiet_NaN() : sign * std::numeric_limits<float>::infinity();
+    }
+    return sign * std::ldexp((float)(mantissa | 0x400), exponent - 25);
+}
+
+static int16_t toSnorm16(const float value) {
+    return (int16_t)std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f);
+}
+
+static float fromSnorm16(const int16_t value) {
+    // -32768 maps to -1 like it does for normalized GL_SHORT attributes
+    return std::max((float)value / 32767.0f, -1.0f);
+}
+
+/* EncodeOctahedral projects the normal onto the octahedron |x| + |y| + |z| = 1 and folds the lower half over the
+ * diagonals, a zero normal encodes as +Z */
+void EncodeOctahedral(const glm::vec3& normal, int16_t encoded[2]) {
+    float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (length == 0.0f) {
+        encoded[0] = encoded[1] = 0;
+        return;
+    }
+
+    glm::vec2 p = glm::vec2(normal.x, normal.y) / length;
+    if (normal.z < 0.0f) {
+        p = glm::vec2((1.0f - std::abs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f),
+                      (1.0f - std::abs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f));
+    }
+
+    encoded[0] = toSnorm16(p.x);
+    encoded[1] = toSnorm16(p.y);
+}
+
+glm::vec3 DecodeOctahedral(const int16_t encoded[2]) {
+    glm::vec3 n(fromSnorm16(encoded[0]), fromSnorm16(encoded[1]), 0.0f);
+    n.z = 1.0f - std::abs(n.x) - std::abs(n.y);
+
+    float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+void PackVertices(const Vertex* vertices, const size_t vertexCount, PackedVertex* packed) {
+    for (size_t i = 0; i < vertexCount; i++) {
+        const Vertex& v = vertices[i];
+        PackedVertex& p = packed[i];
+
+        p.Position[0] = FloatToHalf(v.Position.x);
+        p.Position[1] = FloatToHalf(v.Position.y);
+        p.Position[2] = FloatToHalf(v.Position.z);
+        p.Position[3] = FloatToHalf(1.0f);
+        EncodeOctahedral(v.Normal, p.Normal);
+        p.TexCoord[0] = FloatToHalf(v.TexCoord.x);
+        p.TexCoord[1] = FloatToHalf(v.TexCoord.y);
+    }
+}